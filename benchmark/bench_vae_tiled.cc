@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2018-2050 SD_BenchVAETiled - Arikan.Li
+ * Created by Arikan.Li on 2024/09/16.
+ *
+ * Decode one large latent with the VAE decoder untiled, tiled serial & tiled parallel,
+ * report time & peak RSS of each. Peak RSS never goes down, so every mode runs in its
+ * own process (this executable calls itself with --run).
+ *
+ * usage: bench_vae_tiled <vae_decoder.onnx> [output_size = 1536] [parallel = hardware threads]
+ */
+#include "model_wrapper.cc"
+
+#include <chrono>
+
+#ifdef _WIN32
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+using namespace onnx::sd::base;
+using namespace onnx::sd::units;
+
+#define BENCH_VAE_OUTPUT_SIZE       1536
+#define BENCH_VAE_TILE_SIZE         64      // on latent, 512 px output
+#define BENCH_VAE_TILE_OVERLAP      8
+#define BENCH_VAE_SEED              42
+
+static double peak_rss_mb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters_;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters_, sizeof(counters_));
+    return double(counters_.PeakWorkingSetSize) / (1024.0 * 1024.0);
+#else
+    struct rusage usage_{};
+    getrusage(RUSAGE_SELF, &usage_);
+#ifdef __APPLE__
+    return double(usage_.ru_maxrss) / (1024.0 * 1024.0);     // bytes on macOS
+#else
+    return double(usage_.ru_maxrss) / 1024.0;                // KiB on Linux
+#endif
+#endif
+}
+
+static int run_mode(const std::string &model_path_, uint64_t output_size_, uint64_t tile_size_, uint64_t parallel_) {
+    ONNXRuntimeExecutor executor_;
+    VAE decoder_(model_path_, {
+        0.18215f, output_size_, output_size_, 3,
+        tile_size_, BENCH_VAE_TILE_OVERLAP, parallel_, false,
+    });
+    decoder_.init(executor_, MODEL_ROLE_VAE_DECODER);
+
+    int64_t latent_size_ = int64_t(output_size_ / 8);
+    NoiseGenerator noise_(BENCH_VAE_SEED);
+    Tensor latent_ = TensorHelper::random<float>({1, 4, latent_size_, latent_size_}, noise_);
+    double loaded_rss_ = peak_rss_mb();
+
+    auto begin_ = std::chrono::steady_clock::now();
+    const Tensor &decoded_ = decoder_.decode(latent_);
+    auto end_ = std::chrono::steady_clock::now();
+    TensorShape decoded_shape_ = TensorHelper::get_shape(decoded_);
+
+    char mode_[64];
+    if (tile_size_ == 0) {
+        snprintf(mode_, sizeof(mode_), "untiled");
+    } else {
+        snprintf(mode_, sizeof(mode_), "tiled %llu, parallel %llu",
+                 (unsigned long long) tile_size_, (unsigned long long) parallel_);
+    }
+    printf("%-28s output %lldx%lld  %9.1f ms  peak RSS %8.1f MB (%8.1f MB after model load)\n",
+           mode_, (long long) decoded_shape_[3], (long long) decoded_shape_[2],
+           std::chrono::duration<double, std::milli>(end_ - begin_).count(), peak_rss_mb(), loaded_rss_);
+    fflush(stdout);
+
+    decoder_.release(executor_);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("usage: %s <vae_decoder.onnx> [output_size = %d] [parallel = hardware threads]\n", argv[0], BENCH_VAE_OUTPUT_SIZE);
+        return 1;
+    }
+    std::string model_path_ = argv[1];
+
+    // child: bench_vae_tiled <model> --run <output_size> <tile_size> <parallel>
+    if (argc == 6 && std::string(argv[2]) == "--run") {
+        return run_mode(model_path_, std::stoull(argv[3]), std::stoull(argv[4]), std::stoull(argv[5]));
+    }
+
+    uint64_t output_size_ = (argc > 2) ? std::stoull(argv[2]) : BENCH_VAE_OUTPUT_SIZE;
+    uint64_t parallel_ = (argc > 3) ? std::stoull(argv[3]) : max(uint64_t(std::thread::hardware_concurrency()), uint64_t(1));
+    const uint64_t modes_[][2] = {
+        {0, 1},
+        {BENCH_VAE_TILE_SIZE, 1},
+        {BENCH_VAE_TILE_SIZE, parallel_},
+    };
+    int result_ = 0;
+    for (const auto &mode_ : modes_) {
+        std::string command_ = "\"" + std::string(argv[0]) + "\" \"" + model_path_ + "\" --run " +
+                               std::to_string(output_size_) + " " + std::to_string(mode_[0]) + " " + std::to_string(mode_[1]);
+#ifdef _WIN32
+        command_ = "\"" + command_ + "\"";      // cmd.exe strips the outer quotes
+#endif
+        if (std::system(command_.c_str()) != 0) {
+            printf("mode tile %llu parallel %llu failed\n", (unsigned long long) mode_[0], (unsigned long long) mode_[1]);
+            result_ = 1;
+        }
+    }
+    return result_;
+}
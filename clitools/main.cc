@@ -46,6 +46,16 @@ const char* scheduler_prediction_str[] = {
     "sample",
 };
 
+// below order match AvailableSigmaSpacingType order
+const char* scheduler_spacing_str[] = {
+    "discrete",
+    "trailing",
+    "karras",
+    "exponential",
+    "sigmas",
+    "timesteps",
+};
+
 // below order match AvailablePredictionType order
 const char* scheduler_sampler_fuc_str[] = {
     "euler",
@@ -56,6 +66,9 @@ const char* scheduler_sampler_fuc_str[] = {
     "ddpm",
     "ddim",
     "unipc",
+    "dpmpp_2m",
+    "dpmpp_2m_sde",
+    "dpmpp_3m_sde",
 };
 
 // below order match AvailablePredictionType order
@@ -112,6 +125,8 @@ struct CommandLineInput {
     AvailableBetaType scheduler_beta_type = BETA_TYPE_LINEAR;               // Scheduler: Beta Style (Linear. ScaleLinear, CAP_V2)
     AvailableAlphaType scheduler_alpha_type = ALPHA_TYPE_COSINE;            // Scheduler: Alpha(Beta) Method (Cos, Exp)
     AvailablePredictionType scheduler_predict_type = PREDICT_TYPE_EPSILON;  // Scheduler: Prediction Style (Epsilon, V_Pred, Sample)
+    AvailableSigmaSpacingType scheduler_spacing_type = AVAILABLE_SIGMA_SPACING_LINEAR;// Scheduler: Sigma Spacing (Discrete, Trailing, Karras, Exponential, Table)
+    std::vector<float> scheduler_spacing_table;                             // Scheduler: descending sigmas/timesteps for table spacing
 
     AvailableTokenizerType sd_tokenizer_type = AVAILABLE_TOKENIZER_BPE;     // Tokenizer: tokenizer type (currently only provide BPE)
     std::string tokenizer_dictionary_at;                                    // Tokenizer: vocabulary lib <one vocab per line, row treate as index>
@@ -130,6 +145,19 @@ struct CommandLineInput {
     float sd_scale_guidance = 7.5f;                                         // Infer_Major: immersion rate for [value * (Positive - Negative)] residual
     float sd_random_intensity = 1.0f;                                       // Infer_Major: random intensity for in stepping noise Add (only avail when method supported)
     float sd_decode_scale_strength = 0.18215f;                              // Infer_Major: for VAE Decoding result merged (Recommend 0.18215f)
+    float sd_denoise_strength = 1.0f;                                       // Infer_Major: img2img denoise strength, only last (strength * steps) steps run
+    bool sd_batched_guidance = false;                                       // Infer_Extra: run Positive & Negative UNet passes as one batch-2 call
+    uint64_t sd_batch_count = 1;                                            // Infer_Extra: images count generated in one denoising loop (seed, seed + 1, ...)
+    uint64_t pipeline_queue_depth = 2;                                      // Pipeline: max requests waiting between two stages
+    uint64_t vae_tile_size = 0;                                             // VAE_Tile: encode & decode tile edge in latent pixels (0 for disabled)
+    uint64_t vae_tile_overlap = 8;                                          // VAE_Tile: overlap of neighbour tiles in latent pixels
+    uint64_t vae_tile_parallel = 1;                                         // VAE_Tile: tiles encoded / decoded concurrently
+    int32_t session_encode_threads = 0;                                     // Session: intra-op threads for CLIP & VAE Encoder (0 for ORT default)
+    int32_t session_denoise_threads = 0;                                    // Session: intra-op threads for UNet (0 for ORT default)
+    int32_t session_decode_threads = 0;                                     // Session: intra-op threads for VAE Decoder (0 for ORT default)
+    bool session_no_spinning = false;                                       // Session: disable thread pool spinning for all models (shared hosts)
+    uint64_t sd_prompt_cache_bytes = 64 * 1024 * 1024;                      // Infer_Extra: memory limit of prompt embedding LRU cache in bytes
+    std::string sd_prompt_store_path;                                       // Infer_Extra: directory of persistent prompt embedding store (empty for disabled)
 
     bool verbose = false;  // CLI-Mark: for extra infos of this tools
 };
@@ -205,13 +233,25 @@ void print_params(const CommandLineInput& params) {
     printf("    guidance_factor (UNet):         %.6f\n", params.sd_scale_guidance);
     printf("    decoding_factor (VAE):          %.6f\n", params.sd_decode_scale_strength);
     printf("    strength_factor (Hyper):        %.6f\n", params.sd_random_intensity);
+    printf("    denoise_strength (img2img):     %.6f\n", params.sd_denoise_strength);
     printf("    inference steps:                %llu\n", params.sd_inference_steps);
+    printf("    batched guidance:               %s\n"  , params.sd_batched_guidance ? "true" : "false");
+    printf("    batch count:                    %llu\n", params.sd_batch_count);
+    printf("    stage threads (enc/unet/dec):   %d/%d/%d\n",
+           params.session_encode_threads, params.session_denoise_threads, params.session_decode_threads);
+    printf("    thread spinning:                %s\n"  , params.session_no_spinning ? "off" : "role default");
+    printf("    vae tile (size/overlap/par):    %llu/%llu/%llu\n",
+           params.vae_tile_size, params.vae_tile_overlap, params.vae_tile_parallel);
+    printf("    prompt cache limit (MB):        %llu\n", params.sd_prompt_cache_bytes / (1024 * 1024));
+    printf("    prompt store path:              %s\n"  , params.sd_prompt_store_path.c_str());
 
     printf("  Types  (by User   [maintain]): \n");
     printf("    scheduler_sample_method:        %s\n", scheduler_sampler_fuc_str[params.sd_scheduler_type]);
     printf("    scheduler_beta_type:            %s\n", scheduler_beta_type_str[params.scheduler_beta_type]);
     printf("    scheduler_alpha_type:           %s\n", scheduler_alpha_type_str[params.scheduler_alpha_type]);
     printf("    scheduler_prediction:           %s\n", scheduler_prediction_str[params.scheduler_predict_type]);
+    printf("    scheduler_spacing:              %s\n", scheduler_spacing_str[params.scheduler_spacing_type]);
+    printf("    scheduler_spacing_table:        %zu values\n", params.scheduler_spacing_table.size());
     printf("    tokenizer_series:               %s\n", tokenizer_series_str[params.sd_tokenizer_type]);
 
     printf("  Static (by Models [const]): \n");
@@ -267,12 +307,26 @@ void print_usage(int argc, const char* argv[]) {
     printf("  --decoding <float>                 for VAE Decoding result merged (default 0.18215f) \n");
     printf("  --strength <float>                 set random intensity to control noise adding each step in [0.0, 1.0] (default 1.0f) \n");
     printf("  --steps <uint>                     inference step to generate output (default 3) \n");
+    printf("  --denoise <float>                  img2img denoise strength in (0.0, 1.0], only last (strength * steps) steps run (default 1.0f) \n");
+    printf("  --batch-cfg                        run positive & negative UNet passes as one batch-2 call \n");
+    printf("                                     (WARN: request UNet model exported with dynamic batch axis) \n");
+    printf("  --batch <uint>                     images count generated in one run, with seed, seed + 1, ... (default 1) \n");
+    printf("                                     (WARN: request UNet & VAE models exported with dynamic batch axis) \n");
+    printf("  --stage-threads <enc,unet,dec>     intra-op threads for CLIP & VAE Encoder, UNet, VAE Decoder (default 0,0,0 as ORT default) \n");
+    printf("  --no-spin                          disable ORT thread pool spinning for all models (for shared hosts) \n");
+    printf("  --vae-tile <size[,overlap[,par]]>  VAE encode & decode in overlapping tiles of size (latent pixels, x8 on image), \n");
+    printf("                                     bounding VAE memory for large images, par tiles run concurrently (default 0,8,1 as disabled) \n");
+    printf("  --prompt-cache <uint>              memory limit of prompt embedding cache in MB, 0 only keep empty prompt (default 64) \n");
+    printf("  --prompt-store [STORE_DIR]         directory to persist prompt embeddings across runs & processes (default disabled) \n");
 
     printf("arguments (optional, unrecommended):\n");
-    printf("  --scheduler [TYPE]                 Scheduler Type [euler / euler_a / lms] (default euler_a) \n");
+    printf("  --scheduler [TYPE]                 Scheduler Type [euler / euler_a / lms / lcm / heun / ddpm / ddim / unipc / \n");
+    printf("                                     dpmpp_2m / dpmpp_2m_sde / dpmpp_3m_sde] (default euler_a) \n");
     printf("  --beta [TYPE]                      Beta Style [linear / scale_linear / squared_cos_cap_v2) (default linear) \n");
     printf("  --alpha [TYPE]                     Alpha(Beta) Method [cos / exp] (default cos) \n");
     printf("  --predictor [TYPE]                 Prediction Style [epsilon / v_prediction, sample) (default epsilon) \n");
+    printf("  --spacing [TYPE]                   Sigma Spacing [discrete / trailing / karras / exponential / sigmas / timesteps] (default discrete) \n");
+    printf("  --spacing-table <float,float,...>  descending sigmas (or timesteps) for 'sigmas' ('timesteps') spacing, steps follow table \n");
     printf("  --tokenizer [TYPE]                 Tokenizer Type [bpe] (currently only provide BPE) \n");
 
     printf("  --cache <uint>                     scheduler maintain history count, only avail when used by method (default 4) \n");
@@ -482,12 +536,65 @@ void parse_args(int argc, const char** argv, CommandLineInput& params) {
                 break;
             }
             params.sd_random_intensity = std::stof(argv[i]);
+        } else if (arg == "--denoise") {
+            if (++i >= argc) {
+                invalid_arg = true;
+                break;
+            }
+            params.sd_denoise_strength = std::stof(argv[i]);
         } else if (arg == "--steps") {
             if (++i >= argc) {
                 invalid_arg = true;
                 break;
             }
             params.sd_inference_steps = std::stoi(argv[i]);
+        } else if (arg == "--batch-cfg") {
+            params.sd_batched_guidance = true;
+        } else if (arg == "--batch") {
+            if (++i >= argc) {
+                invalid_arg = true;
+                break;
+            }
+            params.sd_batch_count = std::stoi(argv[i]);
+        } else if (arg == "--vae-tile") {
+            if (++i >= argc) {
+                invalid_arg = true;
+                break;
+            }
+            unsigned long long tile_[3] = {0, params.vae_tile_overlap, params.vae_tile_parallel};
+            if (sscanf(argv[i], "%llu,%llu,%llu", &tile_[0], &tile_[1], &tile_[2]) < 1) {
+                invalid_arg = true;
+                break;
+            }
+            params.vae_tile_size = tile_[0];
+            params.vae_tile_overlap = tile_[1];
+            params.vae_tile_parallel = tile_[2];
+        } else if (arg == "--prompt-cache") {
+            if (++i >= argc) {
+                invalid_arg = true;
+                break;
+            }
+            params.sd_prompt_cache_bytes = uint64_t(std::stoll(argv[i])) * 1024 * 1024;
+        } else if (arg == "--prompt-store") {
+            if (++i >= argc) {
+                invalid_arg = true;
+                break;
+            }
+            params.sd_prompt_store_path = argv[i];
+        } else if (arg == "--stage-threads") {
+            if (++i >= argc) {
+                invalid_arg = true;
+                break;
+            }
+            if (sscanf(argv[i], "%d,%d,%d",
+                       &params.session_encode_threads,
+                       &params.session_denoise_threads,
+                       &params.session_decode_threads) != 3) {
+                invalid_arg = true;
+                break;
+            }
+        } else if (arg == "--no-spin") {
+            params.session_no_spinning = true;
         } else if (arg == "--scheduler") {
             int schedule_found = GET_TYPE_FROM_STR(scheduler_sampler_fuc_str, AVAILABLE_SCHEDULER_COUNT);
             if (schedule_found == -1) {
@@ -516,6 +623,24 @@ void parse_args(int argc, const char** argv, CommandLineInput& params) {
                 break;
             }
             params.scheduler_predict_type = (AvailablePredictionType) predictor_found;
+        } else if (arg == "--spacing") {
+            int spacing_found = GET_TYPE_FROM_STR(scheduler_spacing_str, AVAILABLE_SIGMA_SPACING_COUNT);
+            if (spacing_found == -1) {
+                invalid_arg = true;
+                break;
+            }
+            params.scheduler_spacing_type = (AvailableSigmaSpacingType) spacing_found;
+        } else if (arg == "--spacing-table") {
+            if (++i >= argc) {
+                invalid_arg = true;
+                break;
+            }
+            std::stringstream table_stream(argv[i]);
+            std::string value;
+            params.scheduler_spacing_table.clear();
+            while (std::getline(table_stream, value, ',')) {
+                if (!value.empty()) { params.scheduler_spacing_table.push_back(std::stof(value)); }
+            }
         } else if (arg == "--tokenizer") {
             int tokenizer_found = GET_TYPE_FROM_STR(tokenizer_series_str, AVAILABLE_TOKENIZER_COUNT);
             if (tokenizer_found == -1) {
@@ -613,11 +738,26 @@ void parse_args(int argc, const char** argv, CommandLineInput& params) {
         exit(1);
     }
 
+    if (params.sd_batch_count <= 0) {
+        fprintf(stderr, "error: the batch count must be greater than 0\n");
+        exit(1);
+    }
+
     if (params.sd_decode_scale_strength < 0.f || params.sd_decode_scale_strength > 1.f) {
         fprintf(stderr, "error: can only work with VAE Decoding scale in [0.0, 1.0]\n");
         exit(1);
     }
 
+    if (params.sd_denoise_strength <= 0.f || params.sd_denoise_strength > 1.f) {
+        fprintf(stderr, "error: can only work with denoise strength in (0.0, 1.0]\n");
+        exit(1);
+    }
+
+    if (params.vae_tile_size > 0 && (params.vae_tile_overlap * 2 > params.vae_tile_size || params.vae_tile_parallel <= 0)) {
+        fprintf(stderr, "error: VAE tile overlap must be at most half of tile size, with at least 1 parallel\n");
+        exit(1);
+    }
+
     // seed random check
     if (params.scheduler_seed < 0) {
         std::random_device rd;
@@ -648,6 +788,7 @@ static std::string get_image_params(const CommandLineInput &params) {
     parameter_string += "Scheduler: " + std::string(scheduler_sampler_fuc_str[params.sd_scheduler_type]) + " " +
                         "[ Beta >> " + std::string(scheduler_beta_type_str[params.scheduler_beta_type]) +
                         "  Alpha >> " + std::string(scheduler_alpha_type_str[params.scheduler_alpha_type]) +
+                        "  Spacing >> " + std::string(scheduler_spacing_str[params.scheduler_spacing_type]) +
                         "], " + "\n";
     parameter_string += "Predictor: " + std::string(scheduler_prediction_str[params.scheduler_predict_type]) + ", " + "\n";
     parameter_string += "Tokenizer: " + std::string(tokenizer_series_str[params.sd_tokenizer_type]) + ", " + "\n";
@@ -712,7 +853,7 @@ static void read_image(const CommandLineInput &params, uint8_t** image_data){
     }
 }
 
-static void save_image(const CommandLineInput &params, uint8_t* image_data){
+static void save_image(const CommandLineInput &params, uint8_t* image_data, int batch_at = -1){
     if (!image_data) {
         printf("generate failed\n");
         return;
@@ -720,7 +861,7 @@ static void save_image(const CommandLineInput &params, uint8_t* image_data){
 
     size_t last = params.output_path.find_last_of('.');
     std::string file_name = (last != std::string::npos) ? params.output_path.substr(0, last) : params.output_path;
-    std::string final_image_path = file_name + ".png";
+    std::string final_image_path = file_name + ((batch_at < 0) ? "" : "_" + std::to_string(batch_at)) + ".png";
     stbi_write_png(
         final_image_path.c_str(),
         (int) params.sd_input_width, (int) params.sd_input_height, (int) params.sd_input_channel,
@@ -744,6 +885,7 @@ int main(int argc, const char *argv[]) {
     }
 
     ortsd::IOrtSDContext_ptr ort_sd_context_ = nullptr;
+    AvailableSwitch spinning_ = params.session_no_spinning ? AVAILABLE_SWITCH_OFF : AVAILABLE_SWITCH_DEFAULT;
     ortsd::generate_context(
         &ort_sd_context_,
         {
@@ -765,7 +907,10 @@ int main(int argc, const char *argv[]) {
                 params.scheduler_seed,
                 params.scheduler_beta_type,
                 params.scheduler_alpha_type,
-                params.scheduler_predict_type
+                params.scheduler_predict_type,
+                params.scheduler_spacing_type,
+                params.scheduler_spacing_table.empty() ? nullptr : params.scheduler_spacing_table.data(),
+                uint64_t(params.scheduler_spacing_table.size())
             },
             {
                 params.sd_tokenizer_type,
@@ -784,7 +929,41 @@ int main(int argc, const char *argv[]) {
             params.sd_input_channel,
             params.sd_scale_guidance,
             params.sd_random_intensity,
-            params.sd_decode_scale_strength
+            params.sd_decode_scale_strength,
+            params.sd_denoise_strength,
+            params.sd_batched_guidance,
+            {
+                params.pipeline_queue_depth
+            },
+            {
+                params.vae_tile_size,
+                params.vae_tile_overlap,
+                params.vae_tile_parallel
+            },
+            params.sd_prompt_cache_bytes,
+            params.sd_prompt_store_path.c_str(),
+            {
+                {   // AVAILABLE_MODEL_ROLE_CLIP
+                    AVAILABLE_EXECUTION_MODE_DEFAULT, AVAILABLE_GRAPH_OPTIMIZE_DEFAULT,
+                    params.session_encode_threads, 0,
+                    spinning_, AVAILABLE_SWITCH_DEFAULT, AVAILABLE_SWITCH_DEFAULT
+                },
+                {   // AVAILABLE_MODEL_ROLE_UNET
+                    AVAILABLE_EXECUTION_MODE_DEFAULT, AVAILABLE_GRAPH_OPTIMIZE_DEFAULT,
+                    params.session_denoise_threads, 0,
+                    spinning_, AVAILABLE_SWITCH_DEFAULT, AVAILABLE_SWITCH_DEFAULT
+                },
+                {   // AVAILABLE_MODEL_ROLE_VAE_ENCODER
+                    AVAILABLE_EXECUTION_MODE_DEFAULT, AVAILABLE_GRAPH_OPTIMIZE_DEFAULT,
+                    params.session_encode_threads, 0,
+                    spinning_, AVAILABLE_SWITCH_DEFAULT, AVAILABLE_SWITCH_DEFAULT
+                },
+                {   // AVAILABLE_MODEL_ROLE_VAE_DECODER
+                    AVAILABLE_EXECUTION_MODE_DEFAULT, AVAILABLE_GRAPH_OPTIMIZE_DEFAULT,
+                    params.session_decode_threads, 0,
+                    spinning_, AVAILABLE_SWITCH_DEFAULT, AVAILABLE_SWITCH_DEFAULT
+                }
+            }
         }
     );
     if (!ort_sd_context_) {
@@ -801,9 +980,42 @@ int main(int argc, const char *argv[]) {
 
         ortsd::prepare(ort_sd_context_, params.positive_prompt.c_str(), params.negative_prompt.c_str());
 
-        IO_IMAGE result_output_ = ortsd::inference(ort_sd_context_, {input_image_data, input_image_size});
+        if (params.sd_batch_count > 1) {
+            std::vector<int64_t> batch_seeds(params.sd_batch_count);
+            std::vector<IO_IMAGE> batch_inputs(params.sd_batch_count, IO_IMAGE{input_image_data, input_image_size});
+            std::vector<IO_IMAGE> batch_results(params.sd_batch_count);
+            for (uint64_t b = 0; b < params.sd_batch_count; ++b) {
+                batch_seeds[b] = params.scheduler_seed + int64_t(b);
+            }
+
+            ortsd::inference_batch(
+                ort_sd_context_, batch_seeds.data(), (input_image_data ? batch_inputs.data() : nullptr),
+                params.sd_batch_count, batch_results.data()
+            );
+
+            for (uint64_t b = 0; b < params.sd_batch_count; ++b) {
+                save_image(params, batch_results[b].data_, int(b));
+                ortsd::free_image(&batch_results[b]);
+            }
+        } else {
+            // decoded straight into our own buffer, nothing to free on library side
+            std::vector<uint8_t> result_output_(params.sd_input_width * params.sd_input_height * 3);
+            uint64_t result_size_ = ortsd::inference_into(
+                ort_sd_context_, {input_image_data, input_image_size}, result_output_.data(), result_output_.size()
+            );
+
+            if (result_size_ > 0) {
+                save_image(params, result_output_.data());
+            }
+        }
 
-        save_image(params, result_output_.data_);
+        if (params.verbose) {
+            IOrtSDCacheStatistics cache_stats_ = ortsd::cache_statistics(ort_sd_context_);
+            printf("prompt cache: prompt hit/miss %llu/%llu, chunk hit/miss %llu/%llu, %llu entries, %llu bytes\n",
+                   cache_stats_.prompt_hits, cache_stats_.prompt_misses,
+                   cache_stats_.chunk_hits, cache_stats_.chunk_misses,
+                   cache_stats_.cache_entries, cache_stats_.cache_used_bytes);
+        }
     }
     free(input_image_data);
     // Operation end
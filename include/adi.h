@@ -31,6 +31,53 @@ enum AvailableExecutionType {
     AVAILABLE_EXECUTOR_COUNT,
 };
 
+/* Model Role, each with its own session profile */
+enum AvailableModelRole {
+    AVAILABLE_MODEL_ROLE_CLIP           = 0x00,
+    AVAILABLE_MODEL_ROLE_UNET           = 0x01,
+    AVAILABLE_MODEL_ROLE_VAE_ENCODER    = 0x02,
+    AVAILABLE_MODEL_ROLE_VAE_DECODER    = 0x03,
+    AVAILABLE_MODEL_ROLE_COUNT,
+};
+
+/* Session Graph Execution Mode, DEFAULT (zero) keep role default */
+enum AvailableExecutionMode {
+    AVAILABLE_EXECUTION_MODE_DEFAULT    = 0x00,
+    AVAILABLE_EXECUTION_MODE_SEQUENTIAL = 0x01,
+    AVAILABLE_EXECUTION_MODE_PARALLEL   = 0x02,
+};
+
+/* Session Graph Optimize Level, DEFAULT (zero) keep role default */
+enum AvailableGraphOptimize {
+    AVAILABLE_GRAPH_OPTIMIZE_DEFAULT    = 0x00,
+    AVAILABLE_GRAPH_OPTIMIZE_DISABLE    = 0x01,
+    AVAILABLE_GRAPH_OPTIMIZE_BASIC      = 0x02,
+    AVAILABLE_GRAPH_OPTIMIZE_EXTENDED   = 0x03,
+    AVAILABLE_GRAPH_OPTIMIZE_ALL        = 0x04,
+};
+
+/* Session On-Off Switch, DEFAULT (zero) keep role default */
+enum AvailableSwitch {
+    AVAILABLE_SWITCH_DEFAULT            = 0x00,
+    AVAILABLE_SWITCH_ON                 = 0x01,
+    AVAILABLE_SWITCH_OFF                = 0x02,
+};
+
+/**
+ * @details ORT session options for one model role, all zero means role default
+ *          (default: sequential, all graph optimize, ORT default threads, mem pattern & arena on,
+ *           spinning on for UNet / VAE Decoder, off for CLIP / VAE Encoder)
+ */
+typedef struct IOrtSDSessionProfile {
+    enum AvailableExecutionMode session_execution_mode;  // Session: graph execution mode
+    enum AvailableGraphOptimize session_graph_optimize;  // Session: graph optimize level
+    int32_t session_intra_threads;                       // Session: intra-op threads (0 for ORT default, physical cores)
+    int32_t session_inter_threads;                       // Session: inter-op threads (0 for ORT default, only for PARALLEL)
+    enum AvailableSwitch session_allow_spinning;         // Session: thread pool spin waiting for next kernel
+    enum AvailableSwitch session_memory_pattern;         // Session: memory pattern planning (for fixed input shape)
+    enum AvailableSwitch session_cpu_arena;              // Session: CPU memory arena
+} IOrtSDSessionProfile;
+
 /* Diffusion Abilities Settings ===========================================*/
 
 /* Scheduler Beta Provide */
@@ -56,16 +103,30 @@ enum AvailablePredictionType {
     AVAILABLE_PREDICTOR_COUNT,
 };
 
+/* Scheduler Sigma Spacing Provide */
+enum AvailableSigmaSpacingType {
+    AVAILABLE_SIGMA_SPACING_LINEAR         = 0x00,
+    AVAILABLE_SIGMA_SPACING_TRAILING       = 0x01,
+    AVAILABLE_SIGMA_SPACING_KARRAS         = 0x02,
+    AVAILABLE_SIGMA_SPACING_EXPONENTIAL    = 0x03,
+    AVAILABLE_SIGMA_SPACING_SIGMA_TABLE    = 0x04,
+    AVAILABLE_SIGMA_SPACING_TIMESTEP_TABLE = 0x05,
+    AVAILABLE_SIGMA_SPACING_COUNT,
+};
+
 /* Scheduler Type Provide */
 enum AvailableSchedulerType {
-    AVAILABLE_SCHEDULER_EULER       = 0x00,
-    AVAILABLE_SCHEDULER_EULER_A     = 0x01,
-    AVAILABLE_SCHEDULER_LMS         = 0x02,
-    AVAILABLE_SCHEDULER_LCM         = 0x03,
-    AVAILABLE_SCHEDULER_HEUN        = 0x04,
-    AVAILABLE_SCHEDULER_DDPM        = 0x05,
-    AVAILABLE_SCHEDULER_DDIM        = 0x06,
-    AVAILABLE_SCHEDULER_UNIPC       = 0x07,
+    AVAILABLE_SCHEDULER_EULER        = 0x00,
+    AVAILABLE_SCHEDULER_EULER_A      = 0x01,
+    AVAILABLE_SCHEDULER_LMS          = 0x02,
+    AVAILABLE_SCHEDULER_LCM          = 0x03,
+    AVAILABLE_SCHEDULER_HEUN         = 0x04,
+    AVAILABLE_SCHEDULER_DDPM         = 0x05,
+    AVAILABLE_SCHEDULER_DDIM         = 0x06,
+    AVAILABLE_SCHEDULER_UNIPC        = 0x07,
+    AVAILABLE_SCHEDULER_DPMPP_2M     = 0x08,
+    AVAILABLE_SCHEDULER_DPMPP_2M_SDE = 0x09,
+    AVAILABLE_SCHEDULER_DPMPP_3M_SDE = 0x0A,
     AVAILABLE_SCHEDULER_COUNT,
 };
 
@@ -76,6 +137,15 @@ enum AvailableTokenizerType {
     AVAILABLE_TOKENIZER_COUNT,
 };
 
+/* Async Request State Provide */
+enum AvailableRequestState {
+    AVAILABLE_REQUEST_PENDING       = 0x00,
+    AVAILABLE_REQUEST_RUNNING       = 0x01,
+    AVAILABLE_REQUEST_FINISHED      = 0x02,
+    AVAILABLE_REQUEST_CANCELLED     = 0x03,
+    AVAILABLE_REQUEST_FAILED        = 0x04,
+};
+
 /* Diffusion Main Configuration ===========================================*/
 /* OrtSD Context IO data struct*/
 typedef struct IO_IMAGE {
@@ -109,6 +179,9 @@ typedef struct IOrtSDConfig {
         enum AvailableBetaType scheduler_beta_type;     // Scheduler: Beta Style (Linear. ScaleLinear, CAP_V2)
         enum AvailableAlphaType scheduler_alpha_type;   // Scheduler: Alpha(Beta) Method (Cos, Exp)
         enum AvailablePredictionType scheduler_predict_type;   // Scheduler: Prediction Style (Epsilon, V_Pred, Sample)
+        enum AvailableSigmaSpacingType scheduler_spacing_type; // Scheduler: Sigma Spacing (Linear, Trailing, Karras, Exponential, Table)
+        const float* scheduler_spacing_table;           // Scheduler: descending sigmas/timesteps for table spacing, steps follow table (nullptr for none)
+        uint64_t scheduler_spacing_table_size;          // Scheduler: count of scheduler_spacing_table
     } sd_scheduler_config;
 
     struct {
@@ -130,16 +203,106 @@ typedef struct IOrtSDConfig {
     float sd_scale_guidance;                // Infer_Major: immersion rate for [value * (Positive - Negative)] residual
     float sd_random_intensity;              // Infer_Major: random intensity for in stepping noise Add (only avail when method supported)
     float sd_decode_scale_strength;         // Infer_Major: for VAE Decoding result merged (Recommend 0.18215f)
+    float sd_denoise_strength;              // Infer_Major: img2img denoise strength in (0.0, 1.0], only last (strength * steps) steps run (1.0 for full)
+    bool sd_batched_guidance;               // Infer_Extra: run Positive & Negative UNet passes as one batch-2 call (request UNet with dynamic batch)
+
+    struct {
+        uint64_t pipeline_queue_depth;              // Pipeline: max requests waiting between two stages, submit blocks when full (recommend 2)
+    } sd_pipeline_config;
+
+    struct {
+        uint64_t vae_tile_size;                     // VAE_Tile: encode & decode in tiles of this edge (latent pixels, x8 on image, 0 for disabled, recommend 64)
+        uint64_t vae_tile_overlap;                  // VAE_Tile: overlap of neighbour tiles in latent pixels, feather blended (recommend 8)
+        uint64_t vae_tile_parallel;                 // VAE_Tile: tiles run concurrently, each one holds its own activations (recommend 1)
+    } sd_vae_tile_config;
+
+    uint64_t sd_prompt_cache_bytes;         // Infer_Extra: memory limit of prompt embedding LRU cache in bytes (0 for only pinned empty prompt)
+    const char* sd_prompt_store_path;       // Infer_Extra: directory of persistent prompt embedding store, shared by processes (nullptr for disabled)
+
+    IOrtSDSessionProfile sd_session_profiles[AVAILABLE_MODEL_ROLE_COUNT];  // Base: ORT session profile by model role (index AvailableModelRole)
 } IOrtSDConfig;
 
+/* Prompt embedding cache counters, prompt level for whole prompt, chunk level for each 77-token chunk */
+typedef struct IOrtSDCacheStatistics {
+    uint64_t prompt_hits;
+    uint64_t prompt_misses;
+    uint64_t chunk_hits;
+    uint64_t chunk_misses;
+    uint64_t cache_entries;
+    uint64_t cache_used_bytes;
+    uint64_t cache_limit_bytes;
+} IOrtSDCacheStatistics;
+
 namespace ortsd{
     typedef void* IOrtSDContext_ptr;
+    typedef void* IOrtSDRequest_ptr;
+    /**
+     * @details Async request finished callback, invoked once on worker thread when request reach final state
+     *          (may be before inference_async / inference_pipelined returned, handle already usable then)
+     * @attention never release the owner context inside callback. result_ is the same image request_wait
+     *            returns, free it exactly once by free_image: either in callback, or after request_wait
+     *            (then never request_wait again on this handle)
+     */
+    typedef void (*IOrtSDRequestCallback)(
+        IOrtSDRequest_ptr request_p_, enum AvailableRequestState state_, IO_IMAGE result_, void* user_data_
+    );
 
     ORT_ENTRY void generate_context(IOrtSDContext_ptr* ctx_pp_, struct IOrtSDConfig ctx_config_);
     ORT_ENTRY void released_context(IOrtSDContext_ptr* ctx_pp_);
     ORT_ENTRY void init(IOrtSDContext_ptr ctx_p_);
     ORT_ENTRY void prepare(IOrtSDContext_ptr ctx_p_, const char* positive_prompts_, const char*negative_prompts_);
+    /**
+     * @attention result image allocated by library, must be freed by free_image
+     */
     ORT_ENTRY IO_IMAGE inference(IOrtSDContext_ptr ctx_p_, IO_IMAGE image_data_);
+    /**
+     * @details Same as inference, but result (RGB8, width * height * 3 bytes) written into caller memory,
+     *          e.g. shared-memory segment or preallocated frame pool, nothing allocated for output
+     * @return bytes written, 0 when output_capacity_ too small, context missing or interrupted
+     */
+    ORT_ENTRY uint64_t inference_into(
+        IOrtSDContext_ptr ctx_p_, IO_IMAGE image_data_, uint8_t* output_data_, uint64_t output_capacity_
+    );
+    /**
+     * @details Free image returned by inference / inference_batch / request_wait (never caller owned ones),
+     *          reset to {nullptr, 0}, safe on empty image
+     */
+    ORT_ENTRY void free_image(IO_IMAGE* image_p_);
+    /**
+     * @details Generate batch_size_ images in one denoising loop, sharing current prepared prompts
+     * @param seeds_ [batch_size_] seeds, one for each output image
+     * @param images_ [batch_size_] init images for img2img, or nullptr for txt2img
+     * @param results_ [batch_size_] caller provided slots, filled with generated images (free each by free_image)
+     */
+    ORT_ENTRY void inference_batch(
+        IOrtSDContext_ptr ctx_p_, const int64_t* seeds_, const IO_IMAGE* images_, uint64_t batch_size_,
+        IO_IMAGE* results_
+    );
+    /**
+     * @details Queue one inference on context worker, return immediately with request handle
+     * @param image_data_ init image for img2img (copied on submit), or {nullptr, 0} for txt2img
+     * @param callback_ optional, called when request FINISHED/CANCELLED/FAILED
+     * @attention result image owned by caller (same as inference, free by free_image once, see IOrtSDRequestCallback),
+     *            handle must be freed by released_request
+     */
+    ORT_ENTRY IOrtSDRequest_ptr inference_async(
+        IOrtSDContext_ptr ctx_p_, IO_IMAGE image_data_, IOrtSDRequestCallback callback_, void* user_data_
+    );
+    /**
+     * @details Queue one request into stage pipeline (CLIP & VAE Encode -> UNet -> VAE Decode), each stage
+     *          run on its own thread, so consecutive requests overlap. Prompts carried by request itself,
+     *          current prepared prompts not used.
+     * @attention block when pipeline queue full, result & handle ownership same as inference_async
+     */
+    ORT_ENTRY IOrtSDRequest_ptr inference_pipelined(
+        IOrtSDContext_ptr ctx_p_, const char* positive_prompts_, const char* negative_prompts_, IO_IMAGE image_data_,
+        IOrtSDRequestCallback callback_, void* user_data_
+    );
+    ORT_ENTRY enum AvailableRequestState request_poll(IOrtSDRequest_ptr request_p_);
+    ORT_ENTRY IO_IMAGE request_wait(IOrtSDRequest_ptr request_p_);
+    ORT_ENTRY bool request_cancel(IOrtSDContext_ptr ctx_p_, IOrtSDRequest_ptr request_p_);
+    ORT_ENTRY void released_request(IOrtSDRequest_ptr* request_pp_);
+    ORT_ENTRY IOrtSDCacheStatistics cache_statistics(IOrtSDContext_ptr ctx_p_);
     ORT_ENTRY void release(IOrtSDContext_ptr ctx_p_);
 }
 
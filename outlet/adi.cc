@@ -10,16 +10,79 @@
 #include "adi.h"
 
 namespace ortsd {
+    // public spacing values pass straight through as internal SigmaSpacingType
+    static_assert(int(AVAILABLE_SIGMA_SPACING_LINEAR) == int(onnx::sd::base::SIGMA_SPACING_LINEAR) &&
+                  int(AVAILABLE_SIGMA_SPACING_TRAILING) == int(onnx::sd::base::SIGMA_SPACING_TRAILING) &&
+                  int(AVAILABLE_SIGMA_SPACING_KARRAS) == int(onnx::sd::base::SIGMA_SPACING_KARRAS) &&
+                  int(AVAILABLE_SIGMA_SPACING_EXPONENTIAL) == int(onnx::sd::base::SIGMA_SPACING_EXPONENTIAL) &&
+                  int(AVAILABLE_SIGMA_SPACING_SIGMA_TABLE) == int(onnx::sd::base::SIGMA_SPACING_SIGMA_TABLE) &&
+                  int(AVAILABLE_SIGMA_SPACING_TIMESTEP_TABLE) == int(onnx::sd::base::SIGMA_SPACING_TIMESTEP_TABLE),
+                  "AvailableSigmaSpacingType out of sync with SigmaSpacingType");
+
+    typedef struct IOrtSDRequest {
+        onnx::sd::context::OrtSD_Request_ptr request_;
+    } IOrtSDRequest;
+
+    static onnx::sd::context::OrtSD_RequestCallback wrap_request_callback(
+        IOrtSDRequest *handle_, IOrtSDRequestCallback callback_, void *user_data_
+    ) {
+        if (!callback_) return nullptr;
+        return [handle_, callback_, user_data_](const onnx::sd::context::OrtSD_Request_ptr &request_) {
+            auto result_ = request_->result();
+            callback_(
+                (IOrtSDRequest_ptr) handle_,
+                AvailableRequestState(request_->state()),
+                {result_.data_, result_.size_},
+                user_data_
+            );
+        };
+    }
+
+    static onnx::sd::base::ORTBasicsConfig convert_basics_config(const struct IOrtSDConfig &ctx_config_) {
+        using onnx::sd::base::ExecutionType;
+        onnx::sd::base::ORTBasicsConfig basics_config_ = DEFAULT_EXECUTOR_CONFIG;
+        basics_config_.onnx_execution_type = onnx::sd::base::ExecutionType(ctx_config_.sd_executor_type);
+
+        // only override fields set by caller, zero keep role default
+        const GraphOptimizationLevel graph_levels_[] = {
+            ORT_ENABLE_ALL, ORT_DISABLE_ALL, ORT_ENABLE_BASIC, ORT_ENABLE_EXTENDED, ORT_ENABLE_ALL
+        };
+        for (int i = 0; i < AVAILABLE_MODEL_ROLE_COUNT; ++i) {
+            const IOrtSDSessionProfile &input_ = ctx_config_.sd_session_profiles[i];
+            onnx::sd::base::SessionProfile &profile_ = basics_config_.onnx_session_profiles[i];
+            if (input_.session_execution_mode != AVAILABLE_EXECUTION_MODE_DEFAULT) {
+                profile_.session_execution_mode = (input_.session_execution_mode == AVAILABLE_EXECUTION_MODE_PARALLEL) ?
+                                                  ExecutionMode::ORT_PARALLEL : ExecutionMode::ORT_SEQUENTIAL;
+            }
+            if (input_.session_graph_optimize != AVAILABLE_GRAPH_OPTIMIZE_DEFAULT &&
+                input_.session_graph_optimize <= AVAILABLE_GRAPH_OPTIMIZE_ALL) {
+                profile_.session_graph_optimize = graph_levels_[input_.session_graph_optimize];
+            }
+            if (input_.session_intra_threads > 0) {
+                profile_.session_intra_threads = input_.session_intra_threads;
+            }
+            if (input_.session_inter_threads > 0) {
+                profile_.session_inter_threads = input_.session_inter_threads;
+            }
+            if (input_.session_allow_spinning != AVAILABLE_SWITCH_DEFAULT) {
+                profile_.session_allow_spinning = (input_.session_allow_spinning == AVAILABLE_SWITCH_ON);
+            }
+            if (input_.session_memory_pattern != AVAILABLE_SWITCH_DEFAULT) {
+                profile_.session_memory_pattern = (input_.session_memory_pattern == AVAILABLE_SWITCH_ON);
+            }
+            if (input_.session_cpu_arena != AVAILABLE_SWITCH_DEFAULT) {
+                profile_.session_cpu_arena = (input_.session_cpu_arena == AVAILABLE_SWITCH_ON);
+            }
+        }
+        return basics_config_;
+    }
+
     ORT_ENTRY void generate_context(IOrtSDContext_ptr *ctx_pp_, struct IOrtSDConfig ctx_config_) {
         // If you have any initial checking logic, plz put in there
         if (!ctx_pp_ || (ctx_pp_ && *ctx_pp_)) return;
         *ctx_pp_ = new onnx::sd::context::OrtSD_Context(
             onnx::sd::context::OrtSD_Config{
-                {
-                    onnx::sd::base::ExecutionType(ctx_config_.sd_executor_type),
-                    ExecutionMode::ORT_PARALLEL,
-                    GraphOptimizationLevel::ORT_ENABLE_ALL
-                },
+                convert_basics_config(ctx_config_),
                 {
                     std::string(ctx_config_.sd_modelpath_config.onnx_clip_path),
                     std::string(ctx_config_.sd_modelpath_config.onnx_unet_path),
@@ -37,7 +100,14 @@ namespace ortsd {
                     ctx_config_.sd_scheduler_config.scheduler_seed,
                     onnx::sd::base::BetaType(ctx_config_.sd_scheduler_config.scheduler_beta_type),
                     onnx::sd::base::AlphaType(ctx_config_.sd_scheduler_config.scheduler_alpha_type),
-                    onnx::sd::base::PredictionType(ctx_config_.sd_scheduler_config.scheduler_predict_type)
+                    onnx::sd::base::PredictionType(ctx_config_.sd_scheduler_config.scheduler_predict_type),
+                    onnx::sd::base::SigmaSpacingType(ctx_config_.sd_scheduler_config.scheduler_spacing_type),
+                    ctx_config_.sd_scheduler_config.scheduler_spacing_table ?
+                    std::vector<float>(
+                        ctx_config_.sd_scheduler_config.scheduler_spacing_table,
+                        ctx_config_.sd_scheduler_config.scheduler_spacing_table +
+                        ctx_config_.sd_scheduler_config.scheduler_spacing_table_size
+                    ) : std::vector<float>()
                 },
                 {
                     onnx::sd::base::TokenizerType(ctx_config_.sd_tokenizer_config.sd_tokenizer_type),
@@ -56,7 +126,19 @@ namespace ortsd {
                 ctx_config_.sd_input_channel,
                 ctx_config_.sd_scale_guidance,
                 ctx_config_.sd_random_intensity,
-                ctx_config_.sd_decode_scale_strength
+                ctx_config_.sd_decode_scale_strength,
+                ctx_config_.sd_denoise_strength,
+                ctx_config_.sd_batched_guidance,
+                {
+                    ctx_config_.sd_pipeline_config.pipeline_queue_depth
+                },
+                {
+                    ctx_config_.sd_vae_tile_config.vae_tile_size,
+                    ctx_config_.sd_vae_tile_config.vae_tile_overlap,
+                    ctx_config_.sd_vae_tile_config.vae_tile_parallel
+                },
+                ctx_config_.sd_prompt_cache_bytes,
+                std::string(ctx_config_.sd_prompt_store_path ? ctx_config_.sd_prompt_store_path : "")
             }
         );
     }
@@ -97,6 +179,128 @@ namespace ortsd {
         return image_data_;
     }
 
+    ORT_ENTRY uint64_t inference_into(
+        IOrtSDContext_ptr ctx_p_, IO_IMAGE image_data_, uint8_t *output_data_, uint64_t output_capacity_
+    ) {
+        if (!ctx_p_ || !output_data_) return 0;
+        return ((onnx::sd::context::OrtSD_Context *) ctx_p_)->inference_into(
+            {
+                image_data_.data_,
+                image_data_.size_
+            },
+            output_data_, output_capacity_
+        );
+    }
+
+    ORT_ENTRY void free_image(IO_IMAGE *image_p_) {
+        if (image_p_ && image_p_->data_) {
+            // results made by convert_result with new[]
+            delete[] image_p_->data_;
+        }
+        if (image_p_) { *image_p_ = {nullptr, 0}; }
+    }
+
+    ORT_ENTRY void inference_batch(
+        IOrtSDContext_ptr ctx_p_, const int64_t *seeds_, const IO_IMAGE *images_, uint64_t batch_size_,
+        IO_IMAGE *results_
+    ) {
+        if (ctx_p_ && seeds_ && results_ && batch_size_ > 0) {
+            std::vector<int64_t> batch_seeds_(seeds_, seeds_ + batch_size_);
+            std::vector<onnx::sd::base::IMAGE_DATA> batch_images_;
+            for (uint64_t i = 0; images_ && i < batch_size_; ++i) {
+                batch_images_.push_back({images_[i].data_, images_[i].size_});
+            }
+            auto result_ = ((onnx::sd::context::OrtSD_Context *) ctx_p_)->inference_batch(
+                batch_seeds_, batch_images_
+            );
+            for (uint64_t i = 0; i < batch_size_; ++i) {
+                results_[i] = (i < result_.size()) ?
+                              IO_IMAGE{result_[i].data_, result_[i].size_} :
+                              IO_IMAGE{nullptr, 0};
+            }
+        }
+    }
+
+    ORT_ENTRY IOrtSDRequest_ptr inference_async(
+        IOrtSDContext_ptr ctx_p_, IO_IMAGE image_data_, IOrtSDRequestCallback callback_, void *user_data_
+    ) {
+        if (!ctx_p_) return nullptr;
+        // request stored in handle before submit, callback may fire on worker before submit returns
+        auto *handle_ = new IOrtSDRequest{nullptr};
+        handle_->request_ = std::make_shared<onnx::sd::context::OrtSD_Request>(
+            wrap_request_callback(handle_, callback_, user_data_)
+        );
+        ((onnx::sd::context::OrtSD_Context *) ctx_p_)->inference_async(
+            {
+                image_data_.data_,
+                image_data_.size_
+            },
+            handle_->request_
+        );
+        return (IOrtSDRequest_ptr) handle_;
+    }
+
+    ORT_ENTRY IOrtSDRequest_ptr inference_pipelined(
+        IOrtSDContext_ptr ctx_p_, const char *positive_prompts_, const char *negative_prompts_, IO_IMAGE image_data_,
+        IOrtSDRequestCallback callback_, void *user_data_
+    ) {
+        if (!ctx_p_) return nullptr;
+        auto *handle_ = new IOrtSDRequest{nullptr};
+        handle_->request_ = std::make_shared<onnx::sd::context::OrtSD_Request>(
+            wrap_request_callback(handle_, callback_, user_data_)
+        );
+        ((onnx::sd::context::OrtSD_Context *) ctx_p_)->inference_pipelined(
+            std::string(positive_prompts_ ? positive_prompts_ : ""),
+            std::string(negative_prompts_ ? negative_prompts_ : ""),
+            {
+                image_data_.data_,
+                image_data_.size_
+            },
+            handle_->request_
+        );
+        return (IOrtSDRequest_ptr) handle_;
+    }
+
+    ORT_ENTRY enum AvailableRequestState request_poll(IOrtSDRequest_ptr request_p_) {
+        if (!request_p_) return AVAILABLE_REQUEST_FAILED;
+        return AvailableRequestState(((IOrtSDRequest *) request_p_)->request_->state());
+    }
+
+    ORT_ENTRY IO_IMAGE request_wait(IOrtSDRequest_ptr request_p_) {
+        if (!request_p_) return {nullptr, 0};
+        auto result_ = ((IOrtSDRequest *) request_p_)->request_->wait();
+        return {result_.data_, result_.size_};
+    }
+
+    ORT_ENTRY bool request_cancel(IOrtSDContext_ptr ctx_p_, IOrtSDRequest_ptr request_p_) {
+        if (!ctx_p_ || !request_p_) return false;
+        return ((onnx::sd::context::OrtSD_Context *) ctx_p_)->cancel(((IOrtSDRequest *) request_p_)->request_);
+    }
+
+    ORT_ENTRY void released_request(IOrtSDRequest_ptr *request_pp_) {
+        if (request_pp_ && *request_pp_) {
+            delete ((IOrtSDRequest *) *request_pp_);
+            *request_pp_ = nullptr;
+        }
+    }
+
+    ORT_ENTRY IOrtSDCacheStatistics cache_statistics(IOrtSDContext_ptr ctx_p_) {
+        IOrtSDCacheStatistics result_{};
+        if (ctx_p_) {
+            auto statistics_ = ((onnx::sd::context::OrtSD_Context *) ctx_p_)->cache_statistics();
+            result_ = {
+                statistics_.cache_hits[onnx::sd::base::CACHE_LEVEL_PROMPT],
+                statistics_.cache_misses[onnx::sd::base::CACHE_LEVEL_PROMPT],
+                statistics_.cache_hits[onnx::sd::base::CACHE_LEVEL_CHUNK],
+                statistics_.cache_misses[onnx::sd::base::CACHE_LEVEL_CHUNK],
+                statistics_.cache_entries,
+                statistics_.cache_used_bytes,
+                statistics_.cache_limit_bytes
+            };
+        }
+        return result_;
+    }
+
     ORT_ENTRY void release(IOrtSDContext_ptr ctx_p_) {
         if (ctx_p_) {
             ((onnx::sd::context::OrtSD_Context *) ctx_p_)->release();
@@ -24,6 +24,16 @@ typedef struct ModelPathConfig {
     std::string onnx_safty_path;
 } ModelPathConfig;
 
+typedef struct PipelineConfig {
+    uint64_t pipeline_queue_depth;      // max jobs waiting between two stages (back-pressure when full)
+} PipelineConfig;
+
+typedef struct VAETileConfig {
+    uint64_t vae_tile_size;             // tile edge in latent pixels, 0 for whole latent at once
+    uint64_t vae_tile_overlap;          // overlap of neighbour tiles in latent pixels
+    uint64_t vae_tile_parallel;         // tiles encoded / decoded concurrently
+} VAETileConfig;
+
 typedef struct OrtSD_Config {
     ORTBasicsConfig sd_ort_basic_config; //= {};
     ModelPathConfig sd_modelpath_config; //= {};
@@ -36,8 +46,98 @@ typedef struct OrtSD_Config {
     float sd_scale_guidance            ; //= 0.9f;
     float sd_random_intensity          ; //= 1.0f;
     float sd_decode_scale_strength     ; //= 0.18215f;
+    float sd_denoise_strength          ; //= 1.0f;
+    bool sd_batched_guidance           ; //= false;
+    PipelineConfig sd_pipeline_config  ; //= {2};
+    VAETileConfig sd_vae_tile_config   ; //= {0, 8, 1};
+    uint64_t sd_prompt_cache_bytes     ; //= 64MB;
+    std::string sd_prompt_store_path   ; //= "";
 } OrtSD_Config;
 
+class OrtSD_Request;
+typedef std::shared_ptr<OrtSD_Request> OrtSD_Request_ptr;
+typedef std::function<void(const OrtSD_Request_ptr &)> OrtSD_RequestCallback;
+
+class OrtSD_Request : public std::enable_shared_from_this<OrtSD_Request> {
+private:
+    std::mutex request_lock;
+    std::condition_variable request_signal;
+    RequestState request_state = REQUEST_PENDING;
+    IMAGE_DATA request_result = IMAGE_DATA{nullptr, 0};
+    OrtSD_RequestCallback request_callback;
+    bool request_cancel = false;
+
+public:
+    explicit OrtSD_Request(OrtSD_RequestCallback callback_) : request_callback(std::move(callback_)) {};
+    ~OrtSD_Request() = default;
+
+    RequestState state();
+    IMAGE_DATA result();
+    IMAGE_DATA wait();
+    bool begin();
+    bool cancel();
+    bool cancelled();
+    void finish(RequestState state_, IMAGE_DATA result_);
+};
+
+RequestState OrtSD_Request::state() {
+    std::lock_guard<std::mutex> lock(request_lock);
+    return request_state;
+}
+
+IMAGE_DATA OrtSD_Request::result() {
+    std::lock_guard<std::mutex> lock(request_lock);
+    return request_result;
+}
+
+IMAGE_DATA OrtSD_Request::wait() {
+    std::unique_lock<std::mutex> lock(request_lock);
+    request_signal.wait(lock, [this] {
+        return request_state != REQUEST_PENDING && request_state != REQUEST_RUNNING;
+    });
+    return request_result;
+}
+
+bool OrtSD_Request::begin() {
+    std::lock_guard<std::mutex> lock(request_lock);
+    if (request_state != REQUEST_PENDING) { return false; }
+    request_state = REQUEST_RUNNING;
+    return true;
+}
+
+bool OrtSD_Request::cancel() {
+    std::lock_guard<std::mutex> lock(request_lock);
+    switch (request_state) {
+        case REQUEST_PENDING: {
+            // not started yet, waiters released now, callback fired once dequeued
+            request_cancel = true;
+            request_state = REQUEST_CANCELLED;
+            request_signal.notify_all();
+            return true;
+        }
+        case REQUEST_RUNNING: {
+            request_cancel = true;
+            return true;
+        }
+        default: return false;
+    }
+}
+
+bool OrtSD_Request::cancelled() {
+    std::lock_guard<std::mutex> lock(request_lock);
+    return request_cancel;
+}
+
+void OrtSD_Request::finish(RequestState state_, IMAGE_DATA result_) {
+    {
+        std::lock_guard<std::mutex> lock(request_lock);
+        request_state = state_;
+        request_result = result_;
+        request_signal.notify_all();
+    }
+    if (request_callback) { request_callback(shared_from_this()); }
+}
+
 class OrtSD_Context {
 private:
     typedef struct OrtSD_Remain {
@@ -45,8 +145,34 @@ private:
         Tensor embeded_negative = TensorHelper::create(TensorShape{0}, std::vector<float>{});
     } OrtSD_Remain;
 
+    typedef struct OrtSD_Job {
+        OrtSD_Request_ptr request;
+        std::string positive_prompts;
+        std::string negative_prompts;
+        std::vector<IMAGE_BYTE> image_bytes;
+        Tensor embeded_positive = TensorHelper::empty<float>();
+        Tensor embeded_negative = TensorHelper::empty<float>();
+        Tensor encoded_sample = TensorHelper::empty<float>();
+        Tensor infered_latent = TensorHelper::empty<float>();
+        IMAGE_DATA result = IMAGE_DATA{nullptr, 0};
+    } OrtSD_Job;
+    typedef std::shared_ptr<OrtSD_Job> OrtSD_Job_ptr;
+    typedef std::shared_ptr<WorkerQueue<OrtSD_Job_ptr>> OrtSD_JobQueue_ptr;
+    typedef void (OrtSD_Context::*OrtSD_StageWork)(OrtSD_Job &job_);
+
 private:
     std::mutex ort_thread_lock;
+    std::mutex ort_async_lock;
+    std::mutex ort_encode_lock;     // guard ort_sd_clip & ort_sd_vae_encoder
+    std::mutex ort_denoise_lock;    // guard ort_sd_unet
+    std::mutex ort_decode_lock;     // guard ort_sd_vae_decoder
+
+    OrtSD_JobQueue_ptr ort_pipeline_entry = nullptr;
+    std::vector<std::thread> ort_pipeline_stages;
+
+    WorkerPool* ort_worker_pool = nullptr;
+    OrtSD_Request_ptr ort_running_request = nullptr;
+    std::atomic<bool> ort_async_stopping{false};
 
     ONNXRuntimeExecutor* ort_executor = nullptr;
     OrtSD_Config ort_config;
@@ -58,8 +184,23 @@ private:
     VAE *ort_sd_vae_decoder = nullptr;
 
 private:
+    bool convert_image_into(const IMAGE_DATA &image_data_, float* planar_) const;
     Tensor convert_images(const IMAGE_DATA &image_data_) const;
-    IMAGE_DATA convert_result(const Tensor &infer_output_) const;
+    uint64_t convert_result_into(
+        const Tensor &infer_output_, int64_t batch_at_, IMAGE_BYTE* image_data_, uint64_t image_capacity_
+    ) const;
+    IMAGE_DATA convert_result(const Tensor &infer_output_, int64_t batch_at_ = 0) const;
+    const Tensor& generate_decoded(const IMAGE_DATA &image_data_);
+    IMAGE_DATA generate(const IMAGE_DATA &image_data_);
+    void track_running(const OrtSD_Request_ptr &request_);
+    void conclude(const OrtSD_Request_ptr &request_, RequestState state_, IMAGE_DATA result_);
+    void stop_async();
+
+    void pipeline_start();
+    void pipeline_working(OrtSD_StageWork work_, bool entry_, OrtSD_JobQueue_ptr input_, OrtSD_JobQueue_ptr output_);
+    void pipeline_encode(OrtSD_Job &job_);
+    void pipeline_denoise(OrtSD_Job &job_);
+    void pipeline_decode(OrtSD_Job &job_);
 
 public:
     explicit OrtSD_Context(const OrtSD_Config& ort_config_);
@@ -68,6 +209,16 @@ public:
     void init();
     void prepare(const std::string &positive_prompts_, const std::string &negative_prompts_);
     IMAGE_DATA inference(IMAGE_DATA image_data_);
+    uint64_t inference_into(IMAGE_DATA image_data_, IMAGE_BYTE* output_data_, uint64_t output_capacity_);
+    // request_ created by caller before submit (so callback can already reach it), nullptr for a new one
+    OrtSD_Request_ptr inference_async(IMAGE_DATA image_data_, OrtSD_Request_ptr request_ = nullptr);
+    OrtSD_Request_ptr inference_pipelined(
+        const std::string &positive_prompts_, const std::string &negative_prompts_,
+        IMAGE_DATA image_data_, OrtSD_Request_ptr request_ = nullptr
+    );
+    bool cancel(const OrtSD_Request_ptr &request_);
+    EmbeddingCacheStatistics cache_statistics() const;
+    std::vector<IMAGE_DATA> inference_batch(const std::vector<int64_t> &seeds_, const std::vector<IMAGE_DATA> &images_);
     void release();
 };
 
@@ -77,6 +228,7 @@ OrtSD_Context::OrtSD_Context(const OrtSD_Config& ort_config_){
 }
 
 OrtSD_Context::~OrtSD_Context(){
+    stop_async();
     if (ort_executor != nullptr) {
         delete ort_executor;
         ort_executor = nullptr;
@@ -85,29 +237,33 @@ OrtSD_Context::~OrtSD_Context(){
     this->ort_remain.embeded_positive.release();
 }
 
+bool OrtSD_Context::convert_image_into(const IMAGE_DATA &image_data_, float* planar_) const {
+    long w_ = long(ort_config.sd_input_width);
+    long h_ = long(ort_config.sd_input_height);
+    int c_ = int(ort_config.sd_input_channel);
+    if (c_ < 3 || image_data_.size_ < uint64_t(w_ * h_ * c_)) {
+        amon_report(class_exception(EXC_LOG_ERR, "ERROR:: input image smaller than width * height * channel (RGB at least)"));
+        return false;
+    }
+    // interleaved RGB(A) bytes straight to VAE encoder range, [0, 255] -> [-1, 1]
+    TensorHelper::pixels_to_planar(image_data_.data_, h_, w_, c_, 2.0f / 255.0f, -1.0f, planar_);
+    return true;
+}
+
 Tensor OrtSD_Context::convert_images(const IMAGE_DATA &image_data_) const {
     if (!image_data_.data_) return TensorHelper::empty<float>();
-    IMAGE_BYTE* input_data_ = image_data_.data_;
-    vector<float> convert_value_(image_data_.size_);
-
-    for (int w = 0; w < ort_config.sd_input_width; ++w) {
-        for (int h = 0; h < ort_config.sd_input_height; ++h) {
-            for (int c = 0; c < ort_config.sd_input_channel; ++c) {
-                if (c >= 3) { continue; }
-                int cur_pixel_ = int(h * ort_config.sd_input_width + w) * int(ort_config.sd_input_channel) + c;
-                int tensor_at_ = int(c * ort_config.sd_input_height + h) * int(ort_config.sd_input_width) + w;
-                convert_value_[tensor_at_] = (float(input_data_[cur_pixel_]) / 255.0f);
-            }
-        }
+    int64_t w_ = int64_t(ort_config.sd_input_width);
+    int64_t h_ = int64_t(ort_config.sd_input_height);
+    Tensor convert_tensor_ = TensorHelper::allocate<float>(TensorShape{1, 3, h_, w_});
+    if (!convert_image_into(image_data_, convert_tensor_.GetTensorMutableData<float>())) {
+        return TensorHelper::empty<float>();
     }
-
-    int w_ = int(ort_config.sd_input_width);
-    int h_ = int(ort_config.sd_input_height);
-    TensorShape convert_shape_{1, 3, h_, w_};
-    return TensorHelper::create(convert_shape_, convert_value_);
+    return convert_tensor_;
 }
 
-IMAGE_DATA OrtSD_Context::convert_result(const onnx::sd::base::Tensor &tensor_) const {
+uint64_t OrtSD_Context::convert_result_into(
+    const onnx::sd::base::Tensor &tensor_, int64_t batch_at_, IMAGE_BYTE* image_data_, uint64_t image_capacity_
+) const {
     auto tensor_info = tensor_.GetTensorTypeAndShapeInfo();
     auto shape = tensor_info.GetShape();
 
@@ -120,26 +276,31 @@ IMAGE_DATA OrtSD_Context::convert_result(const onnx::sd::base::Tensor &tensor_)
     int height = int(shape[2]);
     int width = int(shape[3]);
 
-    if (batch_size != 1) {
-        throw std::runtime_error("Batch size > 1 is not supported");
+    if (batch_at_ < 0 || batch_at_ >= batch_size) {
+        throw std::runtime_error("Batch index out of range");
     }
 
-    uint64_t image_size_ = uint64_t(height * width * channels);
-    auto tensor_data_ = tensor_.GetTensorData<float>();
-    auto image_data_ = new IMAGE_BYTE[image_size_];
+    uint64_t image_size_ = uint64_t(height) * uint64_t(width) * uint64_t(channels);
+    if (image_data_ == nullptr || image_capacity_ < image_size_) {
+        amon_report(class_exception(EXC_LOG_ERR, "ERROR:: output buffer smaller than result image"));
+        return 0;
+    }
 
-    for (int c = 0; c < channels; ++c) {
-        for (int h = 0; h < height; ++h) {
-            for (int w = 0; w < width; ++w) {
-                int tensor_at_ = (c * height + h) * width + w;
-                int cur_pixel_ = (h * width + w) * channels + c;
-                image_data_[cur_pixel_] = static_cast<IMAGE_BYTE>(std::round(
-                    min(max(tensor_data_[tensor_at_], 0.0f), 1.0f) * 255
-                ));
-            }
-        }
+    // decoder output [-1, 1] -> (x / 2 + 0.5) * 255, clamped & rounded to interleaved bytes in one pass
+    auto tensor_data_ = tensor_.GetTensorData<float>() + batch_at_ * image_size_;
+    TensorHelper::planar_to_pixels(tensor_data_, height, width, 127.5f, 127.5f, image_data_, channels);
+    return image_size_;
+}
+
+IMAGE_DATA OrtSD_Context::convert_result(const onnx::sd::base::Tensor &tensor_, int64_t batch_at_) const {
+    auto shape = tensor_.GetTensorTypeAndShapeInfo().GetShape();
+    if (shape.size() != 4) {
+        throw std::runtime_error("Expected 4D tensor (N, C, H, W)");
     }
 
+    uint64_t image_size_ = uint64_t(shape[1]) * uint64_t(shape[2]) * uint64_t(shape[3]);
+    auto image_data_ = new IMAGE_BYTE[image_size_];
+    convert_result_into(tensor_, batch_at_, image_data_, image_size_);
     return IMAGE_DATA{image_data_, image_size_};
 }
 
@@ -147,7 +308,9 @@ void OrtSD_Context::init() {
     ort_sd_clip = new Clip(
         ort_config.sd_modelpath_config.onnx_clip_path,
         {
-            ort_config.sd_tokenizer_config
+            ort_config.sd_tokenizer_config,
+            ort_config.sd_prompt_cache_bytes,
+            ort_config.sd_prompt_store_path
         }
     );
 
@@ -160,7 +323,9 @@ void OrtSD_Context::init() {
             ort_config.sd_input_height / 8,
             4,
             ort_config.sd_scale_guidance,
-            ort_config.sd_random_intensity
+            ort_config.sd_random_intensity,
+            ort_config.sd_denoise_strength,
+            ort_config.sd_batched_guidance
         }
     );
 
@@ -171,6 +336,10 @@ void OrtSD_Context::init() {
             ort_config.sd_input_width / 8,
             ort_config.sd_input_height / 8,
             4,
+            ort_config.sd_vae_tile_config.vae_tile_size * 8,
+            ort_config.sd_vae_tile_config.vae_tile_overlap * 8,
+            ort_config.sd_vae_tile_config.vae_tile_parallel,
+            true,
         }
     );
 
@@ -181,18 +350,25 @@ void OrtSD_Context::init() {
             ort_config.sd_input_width,
             ort_config.sd_input_height,
             ort_config.sd_input_channel,
+            ort_config.sd_vae_tile_config.vae_tile_size,
+            ort_config.sd_vae_tile_config.vae_tile_overlap,
+            ort_config.sd_vae_tile_config.vae_tile_parallel,
+            false,
         }
     );
 
-    ort_sd_clip->init(*ort_executor);
-    ort_sd_unet->init(*ort_executor);
-    ort_sd_vae_encoder->init(*ort_executor);
-    ort_sd_vae_decoder->init(*ort_executor);
+    ort_sd_clip->init(*ort_executor, MODEL_ROLE_CLIP);
+    ort_sd_unet->init(*ort_executor, MODEL_ROLE_UNET);
+    ort_sd_vae_encoder->init(*ort_executor, MODEL_ROLE_VAE_ENCODER);
+    ort_sd_vae_decoder->init(*ort_executor, MODEL_ROLE_VAE_DECODER);
+
+    // unconditional (empty prompt) embedding used by almost every request, keep it resident
+    ort_sd_clip->pin("");
 }
 
 void OrtSD_Context::prepare(const std::string &positive_prompts_, const std::string &negative_prompts_){
     // make sure thread security, prevent prepare & inference conflict
-    std::lock_guard<std::mutex> lock(ort_thread_lock);
+    std::scoped_lock lock(ort_thread_lock, ort_encode_lock);
 
     // embeded_positive_ [1, 77 * pos_N, 768], txt_encoder_1
     ort_remain.embeded_positive = ort_sd_clip->embedding(positive_prompts_);
@@ -202,9 +378,26 @@ void OrtSD_Context::prepare(const std::string &positive_prompts_, const std::str
 }
 
 IMAGE_DATA OrtSD_Context::inference(IMAGE_DATA image_data_) {
-    // make sure thread security, prevent prepare & inference conflict
-    std::lock_guard<std::mutex> lock(ort_thread_lock);
+    // make sure thread security, prevent prepare & inference (and pipeline stages) conflict
+    std::scoped_lock lock(ort_thread_lock, ort_encode_lock, ort_denoise_lock, ort_decode_lock);
+    return generate(image_data_);
+}
+
+uint64_t OrtSD_Context::inference_into(IMAGE_DATA image_data_, IMAGE_BYTE* output_data_, uint64_t output_capacity_) {
+    std::scoped_lock lock(ort_thread_lock, ort_encode_lock, ort_denoise_lock, ort_decode_lock);
+    const Tensor &decoded_tensor_ = generate_decoded(image_data_);
+    if (!TensorHelper::have_data(decoded_tensor_)) { return 0; }
+    // quantized straight into caller memory, no result allocation
+    return convert_result_into(decoded_tensor_, 0, output_data_, output_capacity_);
+}
+
+IMAGE_DATA OrtSD_Context::generate(const IMAGE_DATA &image_data_) {
+    const Tensor &decoded_tensor_ = generate_decoded(image_data_);
+    if (!TensorHelper::have_data(decoded_tensor_)) { return IMAGE_DATA{nullptr, 0}; }
+    return convert_result(decoded_tensor_);
+}
 
+const Tensor& OrtSD_Context::generate_decoded(const IMAGE_DATA &image_data_) {
     // input_image [1, 3, 512, 512]
     Tensor sample_image_ = convert_images(image_data_);
 
@@ -214,13 +407,303 @@ IMAGE_DATA OrtSD_Context::inference(IMAGE_DATA image_data_) {
     // infered_latent_ [1, 4, 64, 64]
     Tensor infered_latent_ = ort_sd_unet->inference(ort_remain.embeded_positive, ort_remain.embeded_negative, encoded_sample_);
 
-    // infered_latent_ [1, 3, 512, 512]
-    Tensor decoded_tensor_ = ort_sd_vae_decoder->decode(infered_latent_);
+    // decoded [1, 3, 512, 512], interrupted by cancel leaves latent empty so decode gives empty too
+    return ort_sd_vae_decoder->decode(infered_latent_);
+}
 
-    return convert_result(decoded_tensor_);
+OrtSD_Request_ptr OrtSD_Context::inference_async(IMAGE_DATA image_data_, OrtSD_Request_ptr request_) {
+    if (request_ == nullptr) { request_ = std::make_shared<OrtSD_Request>(nullptr); }
+    if (ort_async_stopping.load()) {
+        request_->finish(REQUEST_CANCELLED, IMAGE_DATA{nullptr, 0});
+        return request_;
+    }
+
+    // caller may release the input right after submit, keep a private copy
+    std::shared_ptr<std::vector<IMAGE_BYTE>> image_copy_ = std::make_shared<std::vector<IMAGE_BYTE>>();
+    if (image_data_.data_) {
+        image_copy_->assign(image_data_.data_, image_data_.data_ + image_data_.size_);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(ort_async_lock);
+        // the context serializes on ort_thread_lock, more workers only queue up on it
+        if (ort_worker_pool == nullptr) { ort_worker_pool = new WorkerPool(1); }
+    }
+
+    bool submitted_ = ort_worker_pool->submit([this, request_, image_copy_]() {
+        IMAGE_DATA result_{nullptr, 0};
+        RequestState state_ = REQUEST_CANCELLED;
+        {
+            // whole context occupied, callback fired after unlock, so it may submit/inference again
+            std::scoped_lock lock(ort_thread_lock, ort_encode_lock, ort_denoise_lock, ort_decode_lock);
+            if (!ort_async_stopping.load() && request_->begin()) {
+                track_running(request_);
+                try {
+                    IMAGE_DATA input_{
+                        image_copy_->empty() ? nullptr : image_copy_->data(),
+                        IMAGE_SIZE(image_copy_->size())
+                    };
+                    result_ = generate(input_);
+                    state_ = REQUEST_FINISHED;
+                } catch (const std::exception &e) {
+                    std::string message_ = std::string("ERROR:: async inference failed, ") + e.what();
+                    amon_report(class_exception(EXC_LOG_ERR, message_.c_str()));
+                    state_ = REQUEST_FAILED;
+                } catch (...) {
+                    amon_report(class_exception(EXC_LOG_ERR, "ERROR:: async inference failed"));
+                    state_ = REQUEST_FAILED;
+                }
+                track_running(nullptr);
+            }
+        }
+        conclude(request_, state_, result_);
+    });
+
+    if (!submitted_) {
+        request_->finish(REQUEST_CANCELLED, IMAGE_DATA{nullptr, 0});
+    }
+    return request_;
+}
+
+void OrtSD_Context::track_running(const OrtSD_Request_ptr &request_) {
+    std::lock_guard<std::mutex> lock(ort_async_lock);
+    // cancel may land right before tracking, check again under ort_async_lock
+    ort_sd_unet->interrupt(request_ != nullptr && request_->cancelled());
+    ort_running_request = request_;
+}
+
+void OrtSD_Context::conclude(const OrtSD_Request_ptr &request_, RequestState state_, IMAGE_DATA result_) {
+    if (request_->cancelled()) {
+        delete[] result_.data_;
+        result_ = IMAGE_DATA{nullptr, 0};
+        state_ = REQUEST_CANCELLED;
+    } else if (state_ == REQUEST_FINISHED && !result_.data_) {
+        state_ = REQUEST_FAILED;
+    }
+    request_->finish(state_, result_);
+}
+
+OrtSD_Request_ptr OrtSD_Context::inference_pipelined(
+    const std::string &positive_prompts_, const std::string &negative_prompts_,
+    IMAGE_DATA image_data_, OrtSD_Request_ptr request_
+) {
+    if (request_ == nullptr) { request_ = std::make_shared<OrtSD_Request>(nullptr); }
+    auto job_ = std::make_shared<OrtSD_Job>();
+    job_->request = request_;
+    job_->positive_prompts = positive_prompts_;
+    job_->negative_prompts = negative_prompts_;
+    if (image_data_.data_) {
+        job_->image_bytes.assign(image_data_.data_, image_data_.data_ + image_data_.size_);
+    }
+
+    OrtSD_JobQueue_ptr entry_ = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(ort_async_lock);
+        if (!ort_async_stopping.load()) {
+            pipeline_start();
+            entry_ = ort_pipeline_entry;
+        }
+    }
+
+    // block here when stages all busy and queue full, keep memory bounded
+    if (entry_ == nullptr || !entry_->push(job_)) {
+        request_->finish(REQUEST_CANCELLED, IMAGE_DATA{nullptr, 0});
+    }
+    return request_;
+}
+
+bool OrtSD_Context::cancel(const OrtSD_Request_ptr &request_) {
+    if (!request_ || !request_->cancel()) { return false; }
+    std::lock_guard<std::mutex> lock(ort_async_lock);
+    if (ort_running_request == request_ && ort_sd_unet != nullptr) {
+        ort_sd_unet->interrupt(true);
+    }
+    return true;
+}
+
+void OrtSD_Context::stop_async() {
+    WorkerPool* worker_pool_ = nullptr;
+    OrtSD_JobQueue_ptr pipeline_entry_ = nullptr;
+    std::vector<std::thread> pipeline_stages_;
+    {
+        std::lock_guard<std::mutex> lock(ort_async_lock);
+        ort_async_stopping.store(true);
+        if (ort_running_request && ort_sd_unet != nullptr) {
+            ort_running_request->cancel();
+            ort_sd_unet->interrupt(true);
+        }
+        worker_pool_ = ort_worker_pool;
+        ort_worker_pool = nullptr;
+        pipeline_entry_ = std::move(ort_pipeline_entry);
+        pipeline_stages_ = std::move(ort_pipeline_stages);
+        ort_pipeline_entry = nullptr;
+        ort_pipeline_stages.clear();
+    }
+    // pending requests drain as cancelled, running one stops at next step
+    if (worker_pool_ != nullptr) {
+        worker_pool_->stop();
+        delete worker_pool_;
+    }
+    // closing entry cascades down the stages, each close its output after drained
+    if (pipeline_entry_ != nullptr) {
+        pipeline_entry_->close();
+    }
+    for (auto &stage_ : pipeline_stages_) {
+        if (stage_.joinable()) { stage_.join(); }
+    }
+}
+
+void OrtSD_Context::pipeline_start() {
+    // called with ort_async_lock held
+    if (ort_pipeline_entry != nullptr) { return; }
+    size_t depth_ = size_t(max(ort_config.sd_pipeline_config.pipeline_queue_depth, uint64_t(1)));
+    OrtSD_JobQueue_ptr encode_queue_ = std::make_shared<WorkerQueue<OrtSD_Job_ptr>>(depth_);
+    OrtSD_JobQueue_ptr denoise_queue_ = std::make_shared<WorkerQueue<OrtSD_Job_ptr>>(depth_);
+    OrtSD_JobQueue_ptr decode_queue_ = std::make_shared<WorkerQueue<OrtSD_Job_ptr>>(depth_);
+
+    ort_pipeline_entry = encode_queue_;
+    ort_pipeline_stages.emplace_back(
+        &OrtSD_Context::pipeline_working, this, &OrtSD_Context::pipeline_encode, true, encode_queue_, denoise_queue_
+    );
+    ort_pipeline_stages.emplace_back(
+        &OrtSD_Context::pipeline_working, this, &OrtSD_Context::pipeline_denoise, false, denoise_queue_, decode_queue_
+    );
+    ort_pipeline_stages.emplace_back(
+        &OrtSD_Context::pipeline_working, this, &OrtSD_Context::pipeline_decode, false, decode_queue_, nullptr
+    );
+}
+
+void OrtSD_Context::pipeline_working(
+    OrtSD_StageWork work_, bool entry_, OrtSD_JobQueue_ptr input_, OrtSD_JobQueue_ptr output_
+) {
+    OrtSD_Job_ptr job_;
+    while (input_->pop(job_)) {
+        bool runnable_ = !ort_async_stopping.load() && (entry_ ? job_->request->begin() : !job_->request->cancelled());
+        if (!runnable_) {
+            conclude(job_->request, REQUEST_CANCELLED, job_->result);
+            continue;
+        }
+
+        try {
+            (this->*work_)(*job_);
+        } catch (const std::exception &e) {
+            std::string message_ = std::string("ERROR:: pipeline stage failed, ") + e.what();
+            amon_report(class_exception(EXC_LOG_ERR, message_.c_str()));
+            conclude(job_->request, REQUEST_FAILED, job_->result);
+            continue;
+        } catch (...) {
+            amon_report(class_exception(EXC_LOG_ERR, "ERROR:: pipeline stage failed"));
+            conclude(job_->request, REQUEST_FAILED, job_->result);
+            continue;
+        }
+
+        if (output_ == nullptr) {
+            conclude(job_->request, REQUEST_FINISHED, job_->result);
+        } else if (!output_->push(job_)) {
+            conclude(job_->request, REQUEST_CANCELLED, job_->result);
+        }
+    }
+    if (output_ != nullptr) { output_->close(); }
+}
+
+void OrtSD_Context::pipeline_encode(OrtSD_Job &job_) {
+    std::lock_guard<std::mutex> lock(ort_encode_lock);
+
+    // embeded_ [1, 77 * N, 768], txt_encoder_1
+    job_.embeded_positive = ort_sd_clip->embedding(job_.positive_prompts);
+    job_.embeded_negative = ort_sd_clip->embedding(job_.negative_prompts);
+
+    // encoded_image [1, 4, 64, 64], or empty for txt2img
+    IMAGE_DATA image_data_{
+        job_.image_bytes.empty() ? nullptr : job_.image_bytes.data(),
+        IMAGE_SIZE(job_.image_bytes.size())
+    };
+    job_.encoded_sample = ort_sd_vae_encoder->encode(convert_images(image_data_));
+    job_.image_bytes.clear();
+}
+
+void OrtSD_Context::pipeline_denoise(OrtSD_Job &job_) {
+    std::lock_guard<std::mutex> lock(ort_denoise_lock);
+    track_running(job_.request);
+    try {
+        // infered_latent_ [1, 4, 64, 64], empty when interrupted
+        job_.infered_latent = ort_sd_unet->inference(job_.embeded_positive, job_.embeded_negative, job_.encoded_sample);
+    } catch (...) {
+        track_running(nullptr);
+        throw;
+    }
+    track_running(nullptr);
+
+    job_.embeded_positive = TensorHelper::empty<float>();
+    job_.embeded_negative = TensorHelper::empty<float>();
+    job_.encoded_sample = TensorHelper::empty<float>();
+}
+
+void OrtSD_Context::pipeline_decode(OrtSD_Job &job_) {
+    std::lock_guard<std::mutex> lock(ort_decode_lock);
+    if (!TensorHelper::have_data(job_.infered_latent)) { return; }
+
+    // decoded_tensor_ [1, 3, 512, 512]
+    const Tensor &decoded_tensor_ = ort_sd_vae_decoder->decode(job_.infered_latent);
+    job_.infered_latent = TensorHelper::empty<float>();
+    job_.result = convert_result(decoded_tensor_);
+}
+
+EmbeddingCacheStatistics OrtSD_Context::cache_statistics() const {
+    if (ort_sd_clip == nullptr) { return EmbeddingCacheStatistics{}; }
+    return ort_sd_clip->cache_statistics();
+}
+
+std::vector<IMAGE_DATA> OrtSD_Context::inference_batch(
+    const std::vector<int64_t> &seeds_,
+    const std::vector<IMAGE_DATA> &images_
+) {
+    // make sure thread security, prevent prepare & inference (and pipeline stages) conflict
+    std::scoped_lock lock(ort_thread_lock, ort_encode_lock, ort_denoise_lock, ort_decode_lock);
+
+    std::vector<IMAGE_DATA> results_;
+    if (seeds_.empty()) { return results_; }
+    if (!images_.empty() && images_.size() != seeds_.size()) {
+        amon_report(class_exception(EXC_LOG_ERR, "ERROR:: batch init images count not match seeds count"));
+        return results_;
+    }
+
+    // input_image [N, 3, 512, 512], only when every batch item provide init image, converted in place
+    Tensor sample_image_ = TensorHelper::empty<float>();
+    if (!images_.empty()) {
+        int64_t w_ = int64_t(ort_config.sd_input_width);
+        int64_t h_ = int64_t(ort_config.sd_input_height);
+        sample_image_ = TensorHelper::allocate<float>(TensorShape{int64_t(images_.size()), 3, h_, w_});
+        float* sample_data_ = sample_image_.GetTensorMutableData<float>();
+        for (size_t n = 0; n < images_.size(); ++n) {
+            if (!images_[n].data_) {
+                amon_report(class_exception(EXC_LOG_ERR, "ERROR:: batch init images must be all provided or all empty"));
+                return results_;
+            }
+            if (!convert_image_into(images_[n], sample_data_ + n * 3 * h_ * w_)) { return results_; }
+        }
+    }
+
+    // encoded_image [N, 4, 64, 64]
+    Tensor encoded_sample_ = ort_sd_vae_encoder->encode(sample_image_);
+
+    // infered_latent_ [N, 4, 64, 64]
+    Tensor infered_latent_ = ort_sd_unet->inference(
+        ort_remain.embeded_positive, ort_remain.embeded_negative, encoded_sample_, seeds_
+    );
+
+    // infered_latent_ [N, 3, 512, 512]
+    const Tensor &decoded_tensor_ = ort_sd_vae_decoder->decode(infered_latent_);
+
+    for (int64_t n = 0; n < int64_t(seeds_.size()); ++n) {
+        results_.push_back(convert_result(decoded_tensor_, n));
+    }
+    return results_;
 }
 
 void OrtSD_Context::release(){
+    stop_async();
+
     ort_sd_vae_decoder->release(*ort_executor);
     ort_sd_vae_encoder->release(*ort_executor);
     ort_sd_unet->release(*ort_executor);
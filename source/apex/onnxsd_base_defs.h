@@ -11,6 +11,7 @@
 #include <cstddef>
 #include <cstdio>
 #include <cstdint>
+#include <cstring>
 
 #include <string>
 #include <algorithm>
@@ -18,6 +19,11 @@
 #include <map>
 #include <cmath>
 #include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <future>
+#include <deque>
+#include <list>
 #include <vector>
 #include <random>
 #include <atomic>
@@ -32,6 +38,22 @@
 #ifdef _WIN32
     #define WIN32_LEAN_AND_MEAN
     #include <Windows.h>    // Only Windows should include windows.h
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define SD_KERNEL_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define SD_KERNEL_NEON
+    #include <arm_neon.h>
 #endif
 
 #include "onnxruntime_cxx_api.h"
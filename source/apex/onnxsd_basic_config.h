@@ -28,6 +28,15 @@ typedef struct IMAGE_DATA {
     uint64_t size_;
 } IMAGE_DATA;
 
+/* Async Request State */
+typedef enum RequestState {
+    REQUEST_PENDING            = 0,
+    REQUEST_RUNNING            = 1,
+    REQUEST_FINISHED           = 2,
+    REQUEST_CANCELLED          = 3,
+    REQUEST_FAILED             = 4,
+} RequestState;
+
 /* ONNXRuntime engine Settings ============================================*/
 
 typedef Ort::Value Tensor;
@@ -46,17 +55,63 @@ typedef enum ExecutionType {
     EXECUTOR_GPU_NNAPI         = 5,
 } ExecutionType;
 
+/* Model Role, each role own its session profile */
+typedef enum ModelRole {
+    MODEL_ROLE_CLIP            = 0,
+    MODEL_ROLE_UNET            = 1,
+    MODEL_ROLE_VAE_ENCODER     = 2,
+    MODEL_ROLE_VAE_DECODER     = 3,
+    MODEL_ROLE_COUNT,
+} ModelRole;
+
+/* short bursts (text / image encode), no spinning so idle cores go back to others */
+#define DEFAULT_ENCODER_SESSION_PROFILE                                 \
+    {                                                                   \
+        /*session_execution_mode*/ ExecutionMode::ORT_SEQUENTIAL,       \
+        /*session_graph_optimize*/ GraphOptimizationLevel::ORT_ENABLE_ALL,\
+        /*session_intra_threads*/  0,                                   \
+        /*session_inter_threads*/  0,                                   \
+        /*session_allow_spinning*/ false,                               \
+        /*session_memory_pattern*/ true,                                \
+        /*session_cpu_arena*/      true                                 \
+    }
+
+/* long hot loops (UNet steps, VAE decode), keep workers spinning between kernels */
+#define DEFAULT_DENOISE_SESSION_PROFILE                                 \
+    {                                                                   \
+        /*session_execution_mode*/ ExecutionMode::ORT_SEQUENTIAL,       \
+        /*session_graph_optimize*/ GraphOptimizationLevel::ORT_ENABLE_ALL,\
+        /*session_intra_threads*/  0,                                   \
+        /*session_inter_threads*/  0,                                   \
+        /*session_allow_spinning*/ true,                                \
+        /*session_memory_pattern*/ true,                                \
+        /*session_cpu_arena*/      true                                 \
+    }
+
+typedef struct SessionProfile {
+    ExecutionMode          session_execution_mode;
+    GraphOptimizationLevel session_graph_optimize;
+    int32_t                session_intra_threads;   // 0 for ORT default (physical cores)
+    int32_t                session_inter_threads;   // 0 for ORT default, only used by ORT_PARALLEL
+    bool                   session_allow_spinning;
+    bool                   session_memory_pattern;
+    bool                   session_cpu_arena;
+} SessionProfile;
+
 #define DEFAULT_EXECUTOR_CONFIG                                         \
     {                                                                   \
         /*onnx_execution_type*/ ExecutionType::EXECUTOR_CPU,            \
-        /*onnx_execution_mode*/ ExecutionMode::ORT_PARALLEL,            \
-        /*onnx_graph_optimize*/ GraphOptimizationLevel::ORT_ENABLE_ALL  \
+        /*onnx_session_profiles*/ {                                     \
+            /*MODEL_ROLE_CLIP*/        DEFAULT_ENCODER_SESSION_PROFILE, \
+            /*MODEL_ROLE_UNET*/        DEFAULT_DENOISE_SESSION_PROFILE, \
+            /*MODEL_ROLE_VAE_ENCODER*/ DEFAULT_ENCODER_SESSION_PROFILE, \
+            /*MODEL_ROLE_VAE_DECODER*/ DEFAULT_DENOISE_SESSION_PROFILE  \
+        }                                                               \
     }
 
 typedef struct ORTBasicsConfig {
     ExecutionType          onnx_execution_type;
-    ExecutionMode          onnx_execution_mode;
-    GraphOptimizationLevel onnx_graph_optimize;
+    SessionProfile         onnx_session_profiles[MODEL_ROLE_COUNT];
 } ORTBasicsConfig;
 
 /* Diffusion Scheduler Settings ===========================================*/
@@ -70,6 +125,9 @@ typedef enum SchedulerType {
     SCHEDULER_DDPM              = 5,
     SCHEDULER_DDIM              = 6,
     SCHEDULER_UNIPC             = 7,
+    SCHEDULER_DPMPP_2M          = 8,
+    SCHEDULER_DPMPP_2M_SDE      = 9,
+    SCHEDULER_DPMPP_3M_SDE      = 10,
 } SchedulerType;
 
 typedef enum BetaScheduleType {
@@ -89,6 +147,15 @@ typedef enum PredictionType {
     PREDICT_TYPE_SAMPLE         = 2,
 } PredictionType;
 
+typedef enum SigmaSpacingType {
+    SIGMA_SPACING_LINEAR        = 0,    // timesteps linear from training_steps - 1 to 0 (discrete)
+    SIGMA_SPACING_TRAILING      = 1,    // timesteps linear from training_steps - 1, last step keeps gap to 0
+    SIGMA_SPACING_KARRAS        = 2,    // sigmas by Karras (rho = 7) between training sigma min & max
+    SIGMA_SPACING_EXPONENTIAL   = 3,    // sigmas log-linear between training sigma max & min
+    SIGMA_SPACING_SIGMA_TABLE   = 4,    // sigmas given by spacing table (descending)
+    SIGMA_SPACING_TIMESTEP_TABLE= 5,    // timesteps given by spacing table (descending)
+} SigmaSpacingType;
+
 #define DEFAULT_SCHEDULER_CONFIG                             \
     {                                                        \
         /*scheduler_type*/              SCHEDULER_EULER_A,   \
@@ -99,7 +166,9 @@ typedef enum PredictionType {
         /*scheduler_seed*/              42,                  \
         /*scheduler_beta_type*/         BETA_TYPE_LINEAR,    \
         /*scheduler_alpha_type*/        ALPHA_TYPE_COSINE,   \
-        /*scheduler_predict_type*/      PREDICT_TYPE_EPSILON \
+        /*scheduler_predict_type*/      PREDICT_TYPE_EPSILON,\
+        /*scheduler_spacing_type*/      SIGMA_SPACING_LINEAR,\
+        /*scheduler_spacing_table*/     {}                   \
     }
 
 typedef struct SchedulerConfig {
@@ -112,6 +181,8 @@ typedef struct SchedulerConfig {
     BetaType scheduler_beta_type;
     AlphaType scheduler_alpha_type;
     PredictionType scheduler_predict_type;
+    SigmaSpacingType scheduler_spacing_type;
+    std::vector<float> scheduler_spacing_table;     // only for table spacing, step count follows table size
 } SchedulerConfig;
 
 /* Diffusion Tokenizer Settings ===========================================*/
@@ -7,6 +7,8 @@
 #define ONNX_SD_CORE_TOOLS_ONCE
 
 #include "onnxsd_basic_refs.h"
+#include "onnxsd_pools.cc"
+#include "onnxsd_kernels.cc"
 
 namespace onnx {
 namespace sd {
@@ -51,6 +53,101 @@ public:
     }
 };
 
+#define NOISE_PHILOX_ROUNDS         10
+#define NOISE_CHUNK_SIZE            1024                    // elements per generation chunk, kept on stack
+#define NOISE_PARALLEL_GRAIN        (1 << 18)               // min elements per thread before splitting
+
+/**
+ * @details Counter-based gaussian noise (Philox4x32-10 + Box-Muller on both outputs), value of
+ *          element i in stream s only depends on (seed, s, i). So any range can be generated alone,
+ *          chunks run in parallel and output is bit-identical whatever the thread count or kernel level.
+ *          Seed -1 picks a random key once, 0 is a valid key. Streams: 0 for initial latent, step + 1
+ *          for per step noise.
+ */
+class NoiseGenerator {
+private:
+    uint64_t noise_key = 0;
+
+private:
+    static void philox(uint64_t key_, uint64_t block_, uint64_t stream_, uint32_t* output_) {
+        uint32_t k0_ = uint32_t(key_), k1_ = uint32_t(key_ >> 32);
+        uint32_t c0_ = uint32_t(block_), c1_ = uint32_t(block_ >> 32);
+        uint32_t c2_ = uint32_t(stream_), c3_ = uint32_t(stream_ >> 32);
+        for (int r = 0; r < NOISE_PHILOX_ROUNDS; ++r) {
+            uint64_t p0_ = uint64_t(0xD2511F53u) * c0_;
+            uint64_t p1_ = uint64_t(0xCD9E8D57u) * c2_;
+            uint32_t n0_ = uint32_t(p1_ >> 32) ^ c1_ ^ k0_;
+            uint32_t n2_ = uint32_t(p0_ >> 32) ^ c3_ ^ k1_;
+            c1_ = uint32_t(p1_);
+            c3_ = uint32_t(p0_);
+            c0_ = n0_;
+            c2_ = n2_;
+            k0_ += 0x9E3779B9u;
+            k1_ += 0xBB67AE85u;
+        }
+        output_[0] = c0_;
+        output_[1] = c1_;
+        output_[2] = c2_;
+        output_[3] = c3_;
+    }
+
+    void fill_range(float* data_, uint64_t begin_, uint64_t end_, uint64_t stream_, float factor_) const {
+        uint32_t bits_[NOISE_CHUNK_SIZE];
+        float normal_[NOISE_CHUNK_SIZE];
+        for (uint64_t at_ = begin_ / NOISE_CHUNK_SIZE * NOISE_CHUNK_SIZE; at_ < end_; at_ += NOISE_CHUNK_SIZE) {
+            for (uint64_t b = 0; b < NOISE_CHUNK_SIZE / 4; ++b) {
+                philox(noise_key, at_ / 4 + b, stream_, bits_ + b * 4);
+            }
+            KernelHelper::box_muller(bits_, normal_, NOISE_CHUNK_SIZE);
+            uint64_t from_ = max(at_, begin_);
+            uint64_t to_ = min(at_ + NOISE_CHUNK_SIZE, end_);
+            KernelHelper::affine<float>(normal_ + (from_ - at_), factor_, 0.0f, data_ + (from_ - begin_), long(to_ - from_));
+        }
+    }
+
+public:
+    explicit NoiseGenerator(int64_t seed_ = 0) {
+        seed(seed_);
+    }
+
+    ~NoiseGenerator() = default;
+
+    // -1 draws a random key on every call, so re-seed per run to get new noise
+    void seed(int64_t seed_) {
+        if (seed_ == -1) {
+            std::random_device rd;
+            seed_ = int64_t((uint64_t(rd()) << 32) | uint64_t(rd()));
+        }
+        noise_key = uint64_t(seed_);
+    }
+
+    /**
+     * @details data[i] = factor * N(0, 1) of element (offset + i) in stream, threads 0 for auto
+     *          (only split when each thread gets NOISE_PARALLEL_GRAIN elements at least).
+     */
+    void fill(float* data_, long size_, uint64_t stream_, uint64_t offset_ = 0, float factor_ = 1.0f, int threads_ = 0) const {
+        if (size_ <= 0) { return; }
+        long workers_ = threads_;
+        if (workers_ <= 0) { workers_ = long(std::thread::hardware_concurrency()); }
+        workers_ = max(min(workers_, size_ / NOISE_PARALLEL_GRAIN), 1L);
+        if (workers_ == 1) {
+            fill_range(data_, offset_, offset_ + uint64_t(size_), stream_, factor_);
+            return;
+        }
+
+        // split on chunk bounds, so no chunk generated twice
+        long piece_ = (size_ / workers_ + NOISE_CHUNK_SIZE - 1) / NOISE_CHUNK_SIZE * NOISE_CHUNK_SIZE;
+        std::vector<std::thread> threads_pool_;
+        for (long begin_ = 0; begin_ < size_; begin_ += piece_) {
+            long end_ = min(begin_ + piece_, size_);
+            threads_pool_.emplace_back([this, data_, begin_, end_, offset_, stream_, factor_]() {
+                fill_range(data_ + begin_, offset_ + uint64_t(begin_), offset_ + uint64_t(end_), stream_, factor_);
+            });
+        }
+        for (auto &thread_ : threads_pool_) { thread_.join(); }
+    }
+};
+
 class IntegralHelper {
 public:
     template<class T>
@@ -77,6 +174,8 @@ public:
     }
 };
 
+#define IMAGE_PARALLEL_GRAIN        (1 << 16)               // min pixels per thread before splitting rows
+
 class TensorHelper {
 
 #define GET_TENSOR_DATA_SIZE(tensor_shape_, shape_size_) \
@@ -219,6 +318,63 @@ public:
         }
     }
 
+    /**
+     * @details Run work_(row_begin, row_end) over image rows, split over threads (threads 0 for auto,
+     *          only split when each thread gets IMAGE_PARALLEL_GRAIN pixels at least).
+     */
+    static void split_rows(long height_, long width_, int threads_, const std::function<void(long, long)> &work_) {
+        if (height_ <= 0 || width_ <= 0) { return; }
+        long workers_ = threads_;
+        if (workers_ <= 0) { workers_ = long(std::thread::hardware_concurrency()); }
+        workers_ = max(min(workers_, height_ * width_ / IMAGE_PARALLEL_GRAIN), 1L);
+        if (workers_ == 1) {
+            work_(0, height_);
+            return;
+        }
+
+        long piece_ = (height_ + workers_ - 1) / workers_;
+        std::vector<std::thread> threads_pool_;
+        for (long begin_ = 0; begin_ < height_; begin_ += piece_) {
+            long end_ = min(begin_ + piece_, height_);
+            threads_pool_.emplace_back([&work_, begin_, end_]() { work_(begin_, end_); });
+        }
+        for (auto &thread_ : threads_pool_) { thread_.join(); }
+    }
+
+    /**
+     * @details Interleaved 8-bit image [H, W, C] to planar float [3, H, W] (value * scale + offset),
+     *          channels beyond 3 (alpha) skipped.
+     */
+    static void pixels_to_planar(
+        const uint8_t* pixels_, long height_, long width_, int channels_,
+        float scale_, float offset_, float* planar_, int threads_ = 0
+    ) {
+        long plane_size_ = height_ * width_;
+        split_rows(height_, width_, threads_, [&](long row_begin_, long row_end_) {
+            KernelHelper::pixels_to_planar(
+                pixels_ + row_begin_ * width_ * channels_, channels_, scale_, offset_,
+                planar_ + row_begin_ * width_, plane_size_, (row_end_ - row_begin_) * width_
+            );
+        });
+    }
+
+    /**
+     * @details Planar float [3, H, W] to interleaved 8-bit image [H, W, C], value * scale + offset
+     *          clamped to [0, 255] & rounded, channels beyond 3 (alpha) set 255.
+     */
+    static void planar_to_pixels(
+        const float* planar_, long height_, long width_, float scale_, float offset_,
+        uint8_t* pixels_, int channels_, int threads_ = 0
+    ) {
+        long plane_size_ = height_ * width_;
+        split_rows(height_, width_, threads_, [&](long row_begin_, long row_end_) {
+            KernelHelper::planar_to_pixels(
+                planar_ + row_begin_ * width_, plane_size_, scale_, offset_,
+                pixels_ + row_begin_ * width_ * channels_, channels_, (row_end_ - row_begin_) * width_
+            );
+        });
+    }
+
     template<class T>
     static Tensor empty() {
         return TensorHelper::create<T>(TensorShape{0}, std::vector<T>{});
@@ -229,18 +385,20 @@ public:
     }
 
     template<class T>
-    static Tensor create(TensorShape shape_, vector<T> value_) {
-        long input_size_ = GET_TENSOR_DATA_SIZE(shape_, 1);
-        auto result_data_ = new T[input_size_];
+    static Tensor allocate(const TensorShape &shape_) {
+        // owning, buffer drawn from (and returned to) TensorPool, contents uninitialized
+        return Tensor::CreateTensor<T>(&TensorPool::instance(), shape_.data(), shape_.size());
+    }
 
-        for (int i = 0; i < input_size_; i++) {
-            result_data_[i] = value_[i];
-        }
+    template<class T>
+    static Tensor view(T* value_data_, const TensorShape &shape_) {
+        // non-owning, value_data_ must outlive the tensor & any binding referring it
+        long input_size_ = GET_TENSOR_DATA_SIZE(shape_, 1);
 
         Tensor result_tensor_ = Tensor::CreateTensor<T>(
             Ort::MemoryInfo::CreateCpu(
                 OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeDefault
-            ), result_data_, input_size_,
+            ), value_data_, input_size_,
             shape_.data(), shape_.size()
         );
 
@@ -248,20 +406,33 @@ public:
     }
 
     template<class T>
-    static Tensor random(TensorShape shape_, RandomGenerator random_, float factor_ = 1.0f) {
+    static Tensor create(const TensorShape &shape_, const vector<T> &value_) {
         long input_size_ = GET_TENSOR_DATA_SIZE(shape_, 1);
-        auto result_data_ = new T[input_size_];
+        Tensor result_tensor_ = allocate<T>(shape_);
+        auto result_data_ = result_tensor_.template GetTensorMutableData<T>();
 
         for (int i = 0; i < input_size_; i++) {
-            result_data_[i] = random_.next() * factor_;
+            result_data_[i] = value_[i];
         }
 
-        Tensor result_tensor_ = Tensor::CreateTensor<T>(
-            Ort::MemoryInfo::CreateCpu(
-                OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeDefault
-            ), result_data_, input_size_,
-            shape_.data(), shape_.size()
-        );
+        return result_tensor_;
+    }
+
+    template<class T>
+    static Tensor random(TensorShape shape_, const NoiseGenerator &random_, float factor_ = 1.0f, uint64_t stream_ = 0) {
+        long input_size_ = GET_TENSOR_DATA_SIZE(shape_, 1);
+        Tensor result_tensor_ = allocate<T>(shape_);
+        auto result_data_ = result_tensor_.template GetTensorMutableData<T>();
+
+        if constexpr (std::is_same<T, float>::value) {
+            random_.fill(result_data_, input_size_, stream_, 0, factor_);
+        } else {
+            vector<float> noise_(input_size_);
+            random_.fill(noise_.data(), input_size_, stream_, 0, factor_);
+            for (int i = 0; i < input_size_; i++) {
+                result_data_[i] = T(noise_[i]);
+            }
+        }
 
         return result_tensor_;
     }
@@ -269,7 +440,6 @@ public:
     template<class T>
     static Tensor blur(const Tensor &input_, RandomGenerator random_, float factor_ = 1.0f) {
         GET_TENSOR_DATA_INFO(input_, input_data_, input_shape_, input_size_, T);
-        auto result_data_ = new T[input_size_];
 
         int64_t max_w_ = input_shape_[3];
         int64_t max_h_ = input_shape_[2];
@@ -277,65 +447,52 @@ public:
         int64_t max_s_ = input_shape_[0];
         int64_t out_c_ = max_c_ / 2;
 
+        TensorShape result_shape_{max_s_, out_c_, max_h_, max_w_};
+        Tensor result_tensor_ = allocate<T>(result_shape_);
+        auto result_data_ = result_tensor_.template GetTensorMutableData<T>();
+
         for (int i = 0; i < max_s_; i++) {
             for (int c = 0; c < out_c_; c++) {
                 for (int h = 0; h < max_h_; h++) {
                     for (int w = 0; w < max_w_; w++) {
                         int64_t cur_at_ = (((i * max_c_ + c) * max_h_ + h) * max_w_ + w) ;
                         int64_t var_at_ = (((i * max_c_ + (c + out_c_)) * max_h_ + h) * max_w_ + w) ;
+                        int64_t out_at_ = (((i * out_c_ + c) * max_h_ + h) * max_w_ + w) ;
                         float mean_ = input_data_[cur_at_];
                         float logvar_ = input_data_[var_at_];
                         logvar_ = max(-30.0f, min(logvar_, 20.0f));
-                        result_data_[i] = mean_ + std::exp(0.5f * logvar_) * random_.next();
-                        result_data_[i] *= factor_;
+                        result_data_[out_at_] = mean_ + std::exp(0.5f * logvar_) * random_.next();
+                        result_data_[out_at_] *= factor_;
                     }
                 }
             }
         }
 
-        TensorShape result_shape_{max_s_, out_c_, max_h_, max_w_};
-        Tensor result_tensor_ = Tensor::CreateTensor<T>(
-            input_.GetTensorMemoryInfo(), result_data_, input_size_,
-            result_shape_.data(), result_shape_.size()
-        );
-
         return result_tensor_;
     }
 
     template<class T>
     static Tensor divide(const Tensor &input_, float denominator_, float offset_ = 0.0f, bool normalize_ = false) {
         GET_TENSOR_DATA_INFO(input_, input_data_, input_shape_, input_size_, T);
-        auto result_data_ = new T[input_size_];
+        Tensor result_tensor_ = allocate<T>(input_shape_);
+        auto result_data_ = result_tensor_.template GetTensorMutableData<T>();
 
-        for (int i = 0; i < input_size_; i++) {
-            result_data_[i] = (
-                normalize_ ?
-                min(max((input_data_[i] / denominator_ + offset_), 0.0f), 1.0f) :
-                (input_data_[i] / denominator_ + offset_)
-            );
+        if (normalize_) {
+            KernelHelper::clamp_affine<T>(input_data_, 1.0f / denominator_, offset_, 0.0f, 1.0f, result_data_, long(input_size_));
+        } else {
+            KernelHelper::affine<T>(input_data_, 1.0f / denominator_, offset_, result_data_, long(input_size_));
         }
 
-        Tensor result_tensor_ = Tensor::CreateTensor<T>(
-            input_.GetTensorMemoryInfo(), result_data_, input_size_,
-            input_shape_.data(), input_shape_.size()
-        );
-
         return result_tensor_;
     }
 
     template<class T>
     static Tensor multiple(const Tensor &input_, float multiplier_, float offset_ = 0.0f) {
         GET_TENSOR_DATA_INFO(input_, input_data_, input_shape_, input_size_, T);
-        auto result_data_ = new T[input_size_];
-
-        for (int i = 0; i < input_size_; i++) {
-            result_data_[i] = input_data_[i] * multiplier_ + offset_;
-        }
+        Tensor result_tensor_ = allocate<T>(input_shape_);
+        auto result_data_ = result_tensor_.template GetTensorMutableData<T>();
 
-        Tensor result_tensor_ = Tensor::CreateTensor<T>(
-            input_.GetTensorMemoryInfo(), result_data_, input_size_,
-            input_shape_.data(), input_shape_.size()
-        );
+        KernelHelper::affine<T>(input_data_, multiplier_, offset_, result_data_, long(input_size_));
 
         return result_tensor_;
     }
@@ -343,19 +500,32 @@ public:
     template<class T>
     static Tensor duplicate(const Tensor &input_) {
         GET_TENSOR_DATA_INFO(input_, input_data_, input_shape_, input_size_, T);
-        T* result_data_ = new T[input_size_ * 2];
+        TensorShape result_shape_ = input_shape_;
+        result_shape_[0] *= 2;
+        Tensor result_tensor_ = allocate<T>(result_shape_);
+        auto result_data_ = result_tensor_.template GetTensorMutableData<T>();
 
         for (int i = 0; i < input_size_; i++) {
             result_data_[i] = input_data_[i];
             result_data_[input_size_ + i] = input_data_[i];
         }
 
+        return result_tensor_;
+    }
+
+    template<class T>
+    static Tensor repeat(const Tensor &input_, int64_t times_) {
+        GET_TENSOR_DATA_INFO(input_, input_data_, input_shape_, input_size_, T);
         TensorShape result_shape_ = input_shape_;
-        result_shape_[0] *= 2;
-        Tensor result_tensor_ = Tensor::CreateTensor<T>(
-            input_.GetTensorMemoryInfo(), result_data_, input_size_ * 2,
-            result_shape_.data(), result_shape_.size()
-        );
+        result_shape_[0] *= times_;
+        Tensor result_tensor_ = allocate<T>(result_shape_);
+        auto result_data_ = result_tensor_.template GetTensorMutableData<T>();
+
+        for (int64_t n = 0; n < times_; n++) {
+            for (int i = 0; i < input_size_; i++) {
+                result_data_[n * input_size_ + i] = input_data_[i];
+            }
+        }
 
         return result_tensor_;
     }
@@ -363,17 +533,46 @@ public:
     template<class T>
     static Tensor clone(const Tensor &input_, const TensorShape &shape_ = {}) {
         GET_TENSOR_DATA_INFO(input_, input_data_, input_shape_, input_size_, T);
-        T* result_data_ = new T[input_size_];
+        TensorShape result_shape_ = shape_.empty() ? input_shape_ : shape_;
+        Tensor result_tensor_ = allocate<T>(result_shape_);
+        auto result_data_ = result_tensor_.template GetTensorMutableData<T>();
 
         for (int i = 0; i < input_size_; i++) {
             result_data_[i] = input_data_[i];
         }
 
-        TensorShape result_shape_ = shape_.empty() ? input_shape_ : shape_;
-        Tensor result_tensor_ = Tensor::CreateTensor<T>(
-            input_.GetTensorMemoryInfo(), result_data_, input_size_,
-            result_shape_.data(), result_shape_.size()
-        );
+        return result_tensor_;
+    }
+
+    /**
+     * @details Planar [N, C, H, W] shrunk to [N, C, height_, width_] by box average, each output pixel
+     *          averages source pixels its cell touches (at least one), so no aliasing on large factors.
+     */
+    template<class T>
+    static Tensor area_resize(const Tensor &input_, int64_t height_, int64_t width_) {
+        auto *input_data_ = input_.GetTensorData<T>();
+        TensorShape input_shape_ = input_.GetTensorTypeAndShapeInfo().GetShape();
+        int64_t in_h_ = input_shape_[2], in_w_ = input_shape_[3];
+        TensorShape result_shape_ = {input_shape_[0], input_shape_[1], height_, width_};
+        Tensor result_tensor_ = allocate<T>(result_shape_);
+        auto result_data_ = result_tensor_.template GetTensorMutableData<T>();
+
+        for (int64_t p = 0; p < input_shape_[0] * input_shape_[1]; ++p) {
+            const T* plane_ = input_data_ + p * in_h_ * in_w_;
+            for (int64_t y = 0; y < height_; ++y) {
+                int64_t y_begin_ = y * in_h_ / height_;
+                int64_t y_end_ = max((y + 1) * in_h_ / height_, y_begin_ + 1);
+                for (int64_t x = 0; x < width_; ++x) {
+                    int64_t x_begin_ = x * in_w_ / width_;
+                    int64_t x_end_ = max((x + 1) * in_w_ / width_, x_begin_ + 1);
+                    double sum_ = 0;
+                    for (int64_t r = y_begin_; r < y_end_; ++r) {
+                        for (int64_t c = x_begin_; c < x_end_; ++c) { sum_ += double(plane_[r * in_w_ + c]); }
+                    }
+                    result_data_[(p * height_ + y) * width_ + x] = T(sum_ / double((y_end_ - y_begin_) * (x_end_ - x_begin_)));
+                }
+            }
+        }
 
         return result_tensor_;
     }
@@ -382,9 +581,11 @@ public:
     static std::vector<Tensor> split(const Tensor &input_, const TensorShape &shape_ = {}) {
         GET_TENSOR_DATA_INFO(input_, input_data_, input_shape_, input_size_, T);
         long split_size_ = GET_TENSOR_DATA_SIZE(shape_, 1);
-        auto split_data_l_ = new T[split_size_];
-        auto split_data_r_ = new T[split_size_];
-        bool enough_data_ = (long(input_size_) == long(split_size_ * 2));
+        std::vector<Tensor> result_;
+        result_.push_back(allocate<T>(shape_));
+        result_.push_back(allocate<T>(shape_));
+        auto split_data_l_ = result_[0].template GetTensorMutableData<T>();
+        auto split_data_r_ = result_[1].template GetTensorMutableData<T>();
 
         int64_t max_w_ = input_shape_[3];
         int64_t max_h_ = input_shape_[2];
@@ -404,16 +605,6 @@ public:
             }
         }
 
-        std::vector<Tensor> result_;
-        result_.push_back(Tensor::CreateTensor<T>(
-            input_.GetTensorMemoryInfo(), split_data_l_, split_size_,
-            shape_.data(), shape_.size()
-        ));
-        result_.push_back(Tensor::CreateTensor<T>(
-            input_.GetTensorMemoryInfo(), split_data_r_, split_size_,
-            shape_.data(), shape_.size()
-        ));
-
         return result_;
     }
 
@@ -423,14 +614,17 @@ public:
         size_t input_size_ = input_tensors_[0].GetTensorTypeAndShapeInfo().GetElementCount();
         long tensor_num_ = long(input_tensors_.size());   // [1, 77, 768]
 
+        TensorShape shape_ = input_shape_;
+        shape_[offset_] *= tensor_num_;
         long result_size_ = long(input_size_ * tensor_num_);
-        auto result_data_ = new T[result_size_];
+        Tensor result_tensor_ = allocate<T>(shape_);
+        auto result_data_ = result_tensor_.template GetTensorMutableData<T>();
 
         long inner_dim = long(std::accumulate(
             input_shape_.begin() + offset_ + 1, input_shape_.end(), 1LL, std::multiplies<>()
         ));  // 768
         long outer_dim = long(std::accumulate(
-            input_shape_.begin(), input_shape_.end() - offset_ - 1, 1LL, std::multiplies<>()
+            input_shape_.begin(), input_shape_.begin() + offset_, 1LL, std::multiplies<>()
         )); // 1
         long concat_dim = long(input_shape_[offset_]);    //  77
         long newest_dim = concat_dim * tensor_num_; // 154
@@ -445,7 +639,6 @@ public:
                         long new_index = l * newest_dim * inner_dim + n * inner_dim + i;
                         //  C6386: make sure in range
                         if (new_index >= result_size_ || old_index >= input_size_) {
-                            delete[] result_data_;
                             throw std::out_of_range("Index out of range");
                         }
                         result_data_[new_index] = input_data_[old_index];
@@ -454,14 +647,6 @@ public:
             }
         }
 
-        TensorShape shape_ = input_shape_;
-        shape_[offset_] *= tensor_num_;
-
-        Tensor result_tensor_ = Tensor::CreateTensor<T>(
-            input_tensors_[0].GetTensorMemoryInfo(), result_data_, result_size_,
-            shape_.data(), shape_.size()
-        );
-
         return result_tensor_;
     }
 
@@ -475,51 +660,44 @@ public:
         }
 
         long result_size_ = long(input_size_l_);
-        auto result_data_ = new T[result_size_];
+        Tensor result_tensor_ = allocate<T>(input_shape_l_);
+        auto result_data_ = result_tensor_.template GetTensorMutableData<T>();
 
-        for (int i = 0; i < result_size_; i++) {
-            result_data_[i] = input_data_l_[i] + guidance_scale_ * (input_data_r_[i] - input_data_l_[i]);
-        }
-
-        TensorShape result_shape_ = input_shape_l_;
-        Tensor result_tensor_ = Tensor::CreateTensor<T>(
-            input_l_.GetTensorMemoryInfo(), result_data_, result_size_,
-            result_shape_.data(), result_shape_.size()
-        );
+        KernelHelper::cfg_combine<T>(input_data_l_, input_data_r_, guidance_scale_, result_data_, result_size_);
 
         return result_tensor_;
     }
 
     template<class T>
     static Tensor weight(const Tensor &input_l_, const Tensor &input_r_, int offset_, bool re_normalize_ = false) {
-        GET_TENSOR_DATA_INFO(input_l_, input_data_l_, input_shape_l_, input_size_l_, T);
-        GET_TENSOR_DATA_INFO(input_r_, input_data_r_, input_shape_r_, input_size_r_, T);
-
-        long result_size_ = long(input_size_l_);
-        auto result_data_ = new T[result_size_];
-
-        float original_mean_ = 0.0f;
-        float weighted_mean_ = 0.0f;
+        auto *input_data_l_ = input_l_.GetTensorData<T>();
+        auto *input_data_r_ = input_r_.GetTensorData<T>();
+        TensorShape input_shape_l_ = input_l_.GetTensorTypeAndShapeInfo().GetShape();
+        TensorShape input_shape_r_ = input_r_.GetTensorTypeAndShapeInfo().GetShape();
+
+        Tensor result_tensor_ = allocate<T>(input_shape_l_);
+        auto result_data_ = result_tensor_.template GetTensorMutableData<T>();
+
+        // means ratio equals sums ratio, weighted sum of row i is weight[i] * row_sum[i],
+        // so only one read pass for sums and one write pass with weight & normalize folded
+        float original_sum_ = 0.0f;
+        float weighted_sum_ = 0.0f;
         size_t elements_per_r = std::accumulate(
             input_shape_l_.begin() + offset_ + 1, input_shape_l_.end(), 1LL, std::multiplies<>()
         );
-        for (size_t i = 0; i < size_t(input_shape_r_[offset_]); ++i) {
-            for (size_t j = 0; j < elements_per_r; ++j) {
-                result_data_[i * elements_per_r + j] = input_data_l_[i * elements_per_r + j] * input_data_r_[i];
-                original_mean_ += input_data_l_[i * elements_per_r + j] / float(input_size_l_) ;
-                weighted_mean_ += result_data_[i * elements_per_r + j] / float(input_size_l_) ;
-            }
-        }
-
-        TensorShape shape_ = input_shape_l_;
-        Tensor result_tensor_ = Tensor::CreateTensor<T>(
-            input_l_.GetTensorMemoryInfo(), result_data_, result_size_,
-            shape_.data(), shape_.size()
-        );
-
-        if (re_normalize_){
-            float normalize_factor_ = original_mean_ / weighted_mean_;
-            result_tensor_ = multiple<T>(result_tensor_, normalize_factor_);
+        size_t rows_ = size_t(input_shape_r_[offset_]);
+        for (size_t i = 0; i < rows_; ++i) {
+            float row_sum_ = KernelHelper::reduce_sum<T>(input_data_l_ + i * elements_per_r, long(elements_per_r));
+            original_sum_ += row_sum_;
+            weighted_sum_ += row_sum_ * float(input_data_r_[i]);
+        }
+
+        float normalize_factor_ = re_normalize_ ? (original_sum_ / weighted_sum_) : 1.0f;
+        for (size_t i = 0; i < rows_; ++i) {
+            KernelHelper::affine<T>(
+                input_data_l_ + i * elements_per_r, float(input_data_r_[i]) * normalize_factor_, 0.0f,
+                result_data_ + i * elements_per_r, long(elements_per_r)
+            );
         }
 
         return result_tensor_;
@@ -535,16 +713,10 @@ public:
         }
 
         long result_size_ = long(input_size_l_);
-        auto result_data_ = new T[result_size_];
-
-        for (int i = 0; i < result_size_; i++) {
-            result_data_[i] = input_data_l_[i] + input_data_r_[i];
-        }
+        Tensor result_tensor_ = allocate<T>(shape_);
+        auto result_data_ = result_tensor_.template GetTensorMutableData<T>();
 
-        Tensor result_tensor_ = Tensor::CreateTensor<T>(
-            input_l_.GetTensorMemoryInfo(), result_data_, result_size_,
-            shape_.data(), shape_.size()
-        );
+        KernelHelper::axpby<T>(1.0f, input_data_l_, 1.0f, input_data_r_, result_data_, result_size_);
 
         return result_tensor_;
     }
@@ -559,26 +731,27 @@ public:
         }
 
         long result_size_ = long(input_size_l_);
-        auto result_data_ = new T[result_size_];
+        Tensor result_tensor_ = allocate<T>(shape_);
+        auto result_data_ = result_tensor_.template GetTensorMutableData<T>();
 
-        for (int i = 0; i < result_size_; i++) {
-            result_data_[i] = input_data_l_[i] - input_data_r_[i];
-        }
-
-        Tensor result_tensor_ = Tensor::CreateTensor<T>(
-            input_l_.GetTensorMemoryInfo(), result_data_, result_size_,
-            shape_.data(), shape_.size()
-        );
+        KernelHelper::axpby<T>(1.0f, input_data_l_, -1.0f, input_data_r_, result_data_, result_size_);
 
         return result_tensor_;
     }
 
     template<class T>
     static Tensor sum(const Tensor* input_tensors_, const long input_size_, const TensorShape& shape_) {
-        Tensor result_ = clone<T>(input_tensors_[0], shape_);
-        for (int i = 1; i < input_size_; ++i) {
-            result_ = add<T>(result_, input_tensors_[i], shape_);
-        }
+        Tensor result_ = allocate<T>(shape_);
+        auto result_data_ = result_.template GetTensorMutableData<T>();
+        // single pass over all inputs, no intermediate tensors
+        std::vector<const T*> input_datas_(input_size_);
+        std::vector<float> input_weights_(input_size_, 1.0f);
+        for (long i = 0; i < input_size_; ++i) {
+            input_datas_[i] = input_tensors_[i].template GetTensorData<T>();
+        }
+        KernelHelper::weighted_sum<T>(
+            input_datas_.data(), input_weights_.data(), int(input_size_), result_data_, get_data_size(result_)
+        );
         return result_;
     }
 
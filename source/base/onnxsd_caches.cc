@@ -0,0 +1,151 @@
+﻿/*
+ * Copyright (c) 2018-2050 SD_Caches - Arikan.Li
+ * Created by Arikan.Li on 2024/08/26.
+ */
+#ifndef ONNX_SD_CORE_CACHES_ONCE
+#define ONNX_SD_CORE_CACHES_ONCE
+
+#include "onnxsd_basic_refs.h"
+#include "onnxsd_basic_tools.cc"
+
+namespace onnx {
+namespace sd {
+namespace base {
+
+typedef enum EmbeddingCacheLevel {
+    CACHE_LEVEL_PROMPT          = 0,    // whole prompt string
+    CACHE_LEVEL_CHUNK           = 1,    // single 77-token chunk, keyed by token ids & weights
+    CACHE_LEVEL_COUNT,
+} EmbeddingCacheLevel;
+
+typedef struct EmbeddingCacheStatistics {
+    uint64_t cache_hits[CACHE_LEVEL_COUNT];
+    uint64_t cache_misses[CACHE_LEVEL_COUNT];
+    uint64_t cache_entries;
+    uint64_t cache_used_bytes;
+    uint64_t cache_limit_bytes;
+} EmbeddingCacheStatistics;
+
+/**
+ * @details LRU cache for float embeddings (shape + values), bounded by memory limit in bytes.
+ *          Pinned entries never evicted (but still counted in used bytes), limit 0 means only
+ *          pinned entries kept. Thread safe.
+ */
+class EmbeddingCache {
+private:
+    typedef struct CacheEntry {
+        std::string cache_key;
+        TensorShape cache_shape;
+        std::vector<float> cache_value;
+        bool cache_pinned;
+    } CacheEntry;
+    typedef std::list<CacheEntry> CacheEntry_list;
+
+private:
+    std::mutex cache_lock;
+    CacheEntry_list cache_entries;      // front for most recently used
+    std::unordered_map<std::string, CacheEntry_list::iterator> cache_index;
+    uint64_t cache_limit_bytes = 0;
+    uint64_t cache_used_bytes = 0;
+    uint64_t cache_hits[CACHE_LEVEL_COUNT] = {0};
+    uint64_t cache_misses[CACHE_LEVEL_COUNT] = {0};
+
+private:
+    static std::string level_key(EmbeddingCacheLevel level_, const std::string &key_) {
+        return std::string(1, char('0' + level_)) + key_;
+    }
+
+    static uint64_t entry_bytes(const CacheEntry &entry_) {
+        return uint64_t(entry_.cache_value.size() * sizeof(float) + entry_.cache_key.size());
+    }
+
+    void evict();
+
+public:
+    explicit EmbeddingCache(uint64_t cache_limit_bytes_ = 0) : cache_limit_bytes(cache_limit_bytes_) {};
+    ~EmbeddingCache() = default;
+
+    bool fetch(EmbeddingCacheLevel level_, const std::string &key_, Tensor &output_);
+    void store(EmbeddingCacheLevel level_, const std::string &key_, const Tensor &value_, bool pinned_ = false);
+    void clear();
+    EmbeddingCacheStatistics statistics();
+};
+
+void EmbeddingCache::evict() {
+    auto it_ = cache_entries.end();
+    while (cache_used_bytes > cache_limit_bytes && it_ != cache_entries.begin()) {
+        --it_;
+        if (it_->cache_pinned) { continue; }
+        cache_used_bytes -= entry_bytes(*it_);
+        cache_index.erase(it_->cache_key);
+        it_ = cache_entries.erase(it_);
+    }
+}
+
+bool EmbeddingCache::fetch(EmbeddingCacheLevel level_, const std::string &key_, Tensor &output_) {
+    std::lock_guard<std::mutex> lock(cache_lock);
+    auto found_ = cache_index.find(level_key(level_, key_));
+    if (found_ == cache_index.end()) {
+        cache_misses[level_]++;
+        return false;
+    }
+    cache_hits[level_]++;
+    cache_entries.splice(cache_entries.begin(), cache_entries, found_->second);
+    output_ = TensorHelper::create(found_->second->cache_shape, found_->second->cache_value);
+    return true;
+}
+
+void EmbeddingCache::store(EmbeddingCacheLevel level_, const std::string &key_, const Tensor &value_, bool pinned_) {
+    CacheEntry entry_{
+        level_key(level_, key_),
+        value_.GetTensorTypeAndShapeInfo().GetShape(),
+        {},
+        pinned_
+    };
+    size_t value_size_ = value_.GetTensorTypeAndShapeInfo().GetElementCount();
+    const float* value_data_ = value_.GetTensorData<float>();
+    entry_.cache_value.assign(value_data_, value_data_ + value_size_);
+
+    uint64_t bytes_ = entry_bytes(entry_);
+    std::lock_guard<std::mutex> lock(cache_lock);
+    if (!pinned_ && bytes_ > cache_limit_bytes) { return; }
+
+    auto found_ = cache_index.find(entry_.cache_key);
+    if (found_ != cache_index.end()) {
+        entry_.cache_pinned = entry_.cache_pinned || found_->second->cache_pinned;
+        cache_used_bytes -= entry_bytes(*found_->second);
+        cache_entries.erase(found_->second);
+        cache_index.erase(found_);
+    }
+
+    cache_entries.push_front(std::move(entry_));
+    cache_index[cache_entries.front().cache_key] = cache_entries.begin();
+    cache_used_bytes += bytes_;
+    evict();
+}
+
+void EmbeddingCache::clear() {
+    std::lock_guard<std::mutex> lock(cache_lock);
+    cache_entries.clear();
+    cache_index.clear();
+    cache_used_bytes = 0;
+}
+
+EmbeddingCacheStatistics EmbeddingCache::statistics() {
+    std::lock_guard<std::mutex> lock(cache_lock);
+    EmbeddingCacheStatistics statistics_{};
+    for (int i = 0; i < CACHE_LEVEL_COUNT; ++i) {
+        statistics_.cache_hits[i] = cache_hits[i];
+        statistics_.cache_misses[i] = cache_misses[i];
+    }
+    statistics_.cache_entries = uint64_t(cache_entries.size());
+    statistics_.cache_used_bytes = cache_used_bytes;
+    statistics_.cache_limit_bytes = cache_limit_bytes;
+    return statistics_;
+}
+
+} // namespace base
+} // namespace sd
+} // namespace onnx
+
+#endif  // ONNX_SD_CORE_CACHES_ONCE
@@ -28,12 +28,101 @@ namespace base {
 using namespace Ort;
 using namespace detail;
 
+/**
+ * @details Process-wide registry of loaded sessions, reference counted by canonical model path &
+ *          session options. Contexts loading the same model share one Ort::Session (Run is thread safe),
+ *          so memory stays flat when scaling contexts. Sessions created on one shared Ort::Env, which
+ *          lives as long as the process.
+ */
+class SessionRegistry {
+private:
+    typedef struct SessionRecord {
+        Ort::Session* record_session;
+        uint64_t record_references;
+    } SessionRecord;
+
+private:
+    std::mutex registry_lock;
+    Ort::Env registry_env{nullptr};
+    std::map<std::string, SessionRecord> registry_records;
+    std::map<Ort::Session*, std::string> registry_keys;
+
+private:
+    SessionRegistry() = default;
+
+public:
+    SessionRegistry(const SessionRegistry&) = delete;
+    SessionRegistry& operator=(const SessionRegistry&) = delete;
+
+    static SessionRegistry& instance() {
+        static SessionRegistry registry_;
+        return registry_;
+    }
+
+    static std::string canonical_path(const std::string &model_path_) {
+#ifdef _WIN32
+        char resolved_[MAX_PATH];
+        DWORD length_ = GetFullPathNameA(model_path_.c_str(), MAX_PATH, resolved_, nullptr);
+        return (length_ > 0 && length_ < MAX_PATH) ? std::string(resolved_, length_) : model_path_;
+#else
+        char* resolved_ = realpath(model_path_.c_str(), nullptr);
+        if (resolved_ == nullptr) { return model_path_; }
+        std::string canonical_(resolved_);
+        free(resolved_);
+        return canonical_;
+#endif
+    }
+
+    Ort::Session* acquire(const std::string &model_path_, const std::string &options_key_, const OrtOptionConfig &options_);
+    void release(Ort::Session* session_);
+};
+
+Ort::Session* SessionRegistry::acquire(
+    const std::string &model_path_, const std::string &options_key_, const OrtOptionConfig &options_
+) {
+    std::string canonical_ = canonical_path(model_path_);
+    std::string key_ = canonical_ + "|" + options_key_;
+
+    // hold lock while loading, concurrent contexts asking same model wait instead of loading twice
+    std::lock_guard<std::mutex> lock(registry_lock);
+    auto found_ = registry_records.find(key_);
+    if (found_ != registry_records.end()) {
+        found_->second.record_references++;
+        return found_->second.record_session;
+    }
+
+    if (!registry_env) {
+        registry_env = Ort::Env{ORT_LOGGING_LEVEL_WARNING, DEFAULT_ORT_ENGINE_NAME};
+    }
+#ifdef _WIN32
+    std::wstring w_model_path = std::wstring(canonical_.begin(), canonical_.end());
+    auto* session_ = new Ort::Session(registry_env, w_model_path.c_str(), options_);
+#else
+    auto* session_ = new Ort::Session(registry_env, canonical_.c_str(), options_);
+#endif
+    registry_records[key_] = SessionRecord{session_, 1};
+    registry_keys[session_] = key_;
+    return session_;
+}
+
+void SessionRegistry::release(Ort::Session* session_) {
+    if (session_ == nullptr) { return; }
+    std::lock_guard<std::mutex> lock(registry_lock);
+    auto key_ = registry_keys.find(session_);
+    if (key_ == registry_keys.end()) { return; }
+    auto record_ = registry_records.find(key_->second);
+    if (record_ != registry_records.end() && --record_->second.record_references == 0) {
+        delete record_->second.record_session;
+        registry_records.erase(record_);
+        registry_keys.erase(key_);
+    }
+}
+
 class ONNXRuntimeExecutor {
 private:
     ORTBasicsConfig ort_commons_config = DEFAULT_EXECUTOR_CONFIG;
     OrtOptionConfig ort_session_config;
     int device_id = 0;
-    Ort::Env ort_env;
 
 private:
     void choose_executor(ExecutionType type_){
@@ -91,39 +180,62 @@ public:
     explicit ONNXRuntimeExecutor(const ORTBasicsConfig &ort_config_ = DEFAULT_EXECUTOR_CONFIG);
     virtual ~ONNXRuntimeExecutor();
 
-    Ort::Session* request_model(const std::string& model_path_);
+    Ort::Session* request_model(const std::string& model_path_, ModelRole model_role_);
     Ort::Session* release_model(Ort::Session* model_ptr_);
 };
 
 ONNXRuntimeExecutor::ONNXRuntimeExecutor(const ORTBasicsConfig &ort_config_) {
     ort_commons_config = ort_config_;
-    ort_env = Ort::Env{ORT_LOGGING_LEVEL_WARNING, DEFAULT_ORT_ENGINE_NAME};
-    ort_session_config.SetGraphOptimizationLevel(ort_config_.onnx_graph_optimize);
-    ort_session_config.SetExecutionMode(ort_config_.onnx_execution_mode);
-
     choose_executor(ort_config_.onnx_execution_type);
 }
 
 ONNXRuntimeExecutor::~ONNXRuntimeExecutor() {
-    ort_env.release();
     ort_session_config.release();
     ort_commons_config = {};
 }
 
-Ort::Session* ONNXRuntimeExecutor::request_model(const std::string& model_path_){
-#ifdef _WIN32
-    std::wstring w_model_path = std::wstring(model_path_.begin(), model_path_.end());
-    return new Ort::Session(ort_env, w_model_path.c_str(), ort_session_config);
-#else
-    return new Ort::Session(ort_env, model_path_.c_str(), ort_session_config);
-#endif
+Ort::Session* ONNXRuntimeExecutor::request_model(const std::string& model_path_, ModelRole model_role_){
+    // providers shared, the rest by role profile
+    const SessionProfile &profile_ = ort_commons_config.onnx_session_profiles[model_role_];
+    OrtOptionConfig session_config_ = ort_session_config.Clone();
+    session_config_.SetExecutionMode(profile_.session_execution_mode);
+    session_config_.SetGraphOptimizationLevel(profile_.session_graph_optimize);
+    if (profile_.session_intra_threads > 0) {
+        session_config_.SetIntraOpNumThreads(profile_.session_intra_threads);
+    }
+    if (profile_.session_inter_threads > 0) {
+        session_config_.SetInterOpNumThreads(profile_.session_inter_threads);
+    }
+    session_config_.AddConfigEntry("session.intra_op.allow_spinning", profile_.session_allow_spinning ? "1" : "0");
+    session_config_.AddConfigEntry("session.inter_op.allow_spinning", profile_.session_allow_spinning ? "1" : "0");
+    if (profile_.session_memory_pattern) {
+        session_config_.EnableMemPattern();
+    } else {
+        session_config_.DisableMemPattern();
+    }
+    if (profile_.session_cpu_arena) {
+        session_config_.EnableCpuMemArena();
+    } else {
+        session_config_.DisableCpuMemArena();
+    }
+
+    // everything applied to session options above must be in key, or sessions shared wrongly
+    std::stringstream options_key_;
+    options_key_ << int(ort_commons_config.onnx_execution_type) << ':'
+                 << device_id << ':'
+                 << int(profile_.session_execution_mode) << ':'
+                 << int(profile_.session_graph_optimize) << ':'
+                 << profile_.session_intra_threads << ':'
+                 << profile_.session_inter_threads << ':'
+                 << profile_.session_allow_spinning << ':'
+                 << profile_.session_memory_pattern << ':'
+                 << profile_.session_cpu_arena;
+    return SessionRegistry::instance().acquire(model_path_, options_key_.str(), session_config_);
 }
 
 Ort::Session* ONNXRuntimeExecutor::release_model(Ort::Session* model_ptr_){
-    if (model_ptr_){
-        model_ptr_->release();
-        delete model_ptr_;
-    }
+    // shared session, only destroyed when last context using it released
+    SessionRegistry::instance().release(model_ptr_);
     return nullptr;
 }
 
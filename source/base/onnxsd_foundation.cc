@@ -6,7 +6,12 @@
 #define BASEMENT_REGISTER_ONCE
 
 #include "onnxsd_basic_refs.h"
+#include "onnxsd_pools.cc"
+#include "onnxsd_kernels.cc"
 #include "onnxsd_basic_tools.cc"
+#include "onnxsd_workers.cc"
+#include "onnxsd_caches.cc"
+#include "onnxsd_storage.cc"
 #include "onnxsd_executor.cc"
 
 #endif  // BASEMENT_REGISTER_ONCE
\ No newline at end of file
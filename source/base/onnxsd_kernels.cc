@@ -0,0 +1,977 @@
+﻿/*
+ * Copyright (c) 2018-2050 SD_Kernels - Arikan.Li
+ * Created by Arikan.Li on 2024/09/06.
+ */
+#ifndef ONNX_SD_CORE_KERNELS_ONCE
+#define ONNX_SD_CORE_KERNELS_ONCE
+
+#include "onnxsd_basic_refs.h"
+
+namespace onnx {
+namespace sd {
+namespace base {
+using namespace amon;
+
+#if defined(SD_KERNEL_X86) && !(defined(_MSC_VER) && !defined(__clang__))
+    #define SD_KERNEL_TARGET_AVX2       __attribute__((target("avx2,fma")))
+    #define SD_KERNEL_TARGET_AVX512     __attribute__((target("avx512f")))
+#else
+    #define SD_KERNEL_TARGET_AVX2
+    #define SD_KERNEL_TARGET_AVX512
+#endif
+
+// gcc contracts mul/add (even intrinsics) into fma by default for c++, exact kernels must opt out
+#if defined(__GNUC__) && !defined(__clang__)
+    #define SD_KERNEL_EXACT             __attribute__((optimize("fp-contract=off")))
+#else
+    #define SD_KERNEL_EXACT
+#endif
+
+// Box-Muller group layout: words [0, 16) feed radius, [16, 32) angle, output [0, 16) gets cos, [16, 32) sin.
+// Fixed for every instruction set, so the same bits map to the same normals whatever the vector width.
+#define KERNEL_BOX_MULLER_GROUP     32
+#define KERNEL_BOX_MULLER_HALF      16
+#define KERNEL_INV_2_24             5.9604644775390625e-8f
+#define KERNEL_TWO_PI               6.28318530717958647692f
+// cephes logf / sincosf constants
+#define KERNEL_SQRTHF               0.707106781186547524f
+#define KERNEL_LOG_P0               7.0376836292e-2f
+#define KERNEL_LOG_P1               -1.1514610310e-1f
+#define KERNEL_LOG_P2               1.1676998740e-1f
+#define KERNEL_LOG_P3               -1.2420140846e-1f
+#define KERNEL_LOG_P4               1.4249322787e-1f
+#define KERNEL_LOG_P5               -1.6668057665e-1f
+#define KERNEL_LOG_P6               2.0000714765e-1f
+#define KERNEL_LOG_P7               -2.4999993993e-1f
+#define KERNEL_LOG_P8               3.3333331174e-1f
+#define KERNEL_LOG_Q1               -2.12194440e-4f
+#define KERNEL_LOG_Q2               0.693359375f
+#define KERNEL_FOPI                 1.27323954473516f
+#define KERNEL_DP1                  0.78515625f
+#define KERNEL_DP2                  2.4187564849853515625e-4f
+#define KERNEL_DP3                  3.77489497744594108e-8f
+#define KERNEL_SIN_P0               -1.9515295891e-4f
+#define KERNEL_SIN_P1               8.3321608736e-3f
+#define KERNEL_SIN_P2               -1.6666654611e-1f
+#define KERNEL_COS_P0               2.443315711809948e-5f
+#define KERNEL_COS_P1               -1.388731625493765e-3f
+#define KERNEL_COS_P2               4.166664568298827e-2f
+// pixel conversion: first 3 channels are color planes, extra ones (alpha) skipped on read & set 255 on write
+#define KERNEL_PIXEL_PLANES         3
+#define KERNEL_PIXEL_MAX            255.0f
+
+typedef enum KernelLevel {
+    KERNEL_LEVEL_SCALAR         = 0,
+    KERNEL_LEVEL_NEON           = 1,
+    KERNEL_LEVEL_AVX2           = 2,
+    KERNEL_LEVEL_AVX512         = 3,
+} KernelLevel;
+
+/**
+ * @details Element-wise float kernels, one variant per instruction set, picked once at first use
+ *          by cpu detection (NEON is baseline on arm64). Outputs may alias inputs, all loops use
+ *          long indices & keep branches out of the body. Scalar variants are the reference.
+ *          Box-Muller & pixel conversion variants use plain mul/add in one fixed order (no fma), results
+ *          are bit-identical across levels.
+ */
+namespace kernels {
+
+typedef struct KernelTable {
+    KernelLevel level;
+    // out = a * x + b * y
+    void (*axpby)(float a_, const float* x_, float b_, const float* y_, float* out_, long size_);
+    // out = clamp(x * scale + offset, lower, upper)
+    void (*clamp_affine)(const float* x_, float scale_, float offset_, float lower_, float upper_, float* out_, long size_);
+    // out = sum_k(weights[k] * inputs[k])
+    void (*weighted_sum)(const float* const* inputs_, const float* weights_, int count_, float* out_, long size_);
+    // out = negative + scale * (positive - negative)
+    void (*cfg_combine)(const float* negative_, const float* positive_, float scale_, float* out_, long size_);
+    // return sum(x)
+    float (*reduce_sum)(const float* x_, long size_);
+    // out = gaussian pairs from 32-bit uniform words, size multiple of KERNEL_BOX_MULLER_GROUP
+    void (*box_muller)(const uint32_t* bits_, float* out_, long size_);
+    // planar[c * plane_size + i] = pixels[i * channels + c] * scale + offset
+    void (*pixels_to_planar)(
+        const uint8_t* pixels_, int channels_, float scale_, float offset_, float* planar_, long plane_size_, long count_
+    );
+    // pixels[i * channels + c] = round(clamp(planar[c * plane_size + i] * scale + offset, 0, 255))
+    void (*planar_to_pixels)(
+        const float* planar_, long plane_size_, float scale_, float offset_, uint8_t* pixels_, int channels_, long count_
+    );
+} KernelTable;
+
+/* Scalar =================================================================*/
+static void axpby_scalar(float a_, const float* x_, float b_, const float* y_, float* out_, long size_) {
+    for (long i = 0; i < size_; ++i) { out_[i] = a_ * x_[i] + b_ * y_[i]; }
+}
+
+static void clamp_affine_scalar(
+    const float* x_, float scale_, float offset_, float lower_, float upper_, float* out_, long size_
+) {
+    for (long i = 0; i < size_; ++i) { out_[i] = min(max(x_[i] * scale_ + offset_, lower_), upper_); }
+}
+
+static void weighted_sum_scalar(const float* const* inputs_, const float* weights_, int count_, float* out_, long size_) {
+    for (long i = 0; i < size_; ++i) {
+        float sum_ = 0.0f;
+        for (int k = 0; k < count_; ++k) { sum_ += weights_[k] * inputs_[k][i]; }
+        out_[i] = sum_;
+    }
+}
+
+static void cfg_combine_scalar(const float* negative_, const float* positive_, float scale_, float* out_, long size_) {
+    for (long i = 0; i < size_; ++i) { out_[i] = negative_[i] + scale_ * (positive_[i] - negative_[i]); }
+}
+
+static float reduce_sum_scalar(const float* x_, long size_) {
+    float sum_ = 0.0f;
+    for (long i = 0; i < size_; ++i) { sum_ += x_[i]; }
+    return sum_;
+}
+
+static inline float bits_as_float(uint32_t bits_) {
+    float value_;
+    memcpy(&value_, &bits_, sizeof(float));
+    return value_;
+}
+
+static inline uint32_t float_as_bits(float value_) {
+    uint32_t bits_;
+    memcpy(&bits_, &value_, sizeof(float));
+    return bits_;
+}
+
+// x in (0, 1], one statement per operation so nothing gets contracted
+SD_KERNEL_EXACT
+static inline float log_scalar(float x_) {
+    uint32_t xi_ = float_as_bits(x_);
+    float e_ = float(int32_t(xi_ >> 23) - 126);
+    float m_ = bits_as_float((xi_ & 0x007FFFFFu) | 0x3F000000u);
+    bool low_ = m_ < KERNEL_SQRTHF;
+    float tmp_ = low_ ? m_ : 0.0f;
+    m_ = m_ - 1.0f;
+    e_ = e_ - (low_ ? 1.0f : 0.0f);
+    m_ = m_ + tmp_;
+    float z_ = m_ * m_;
+    float y_ = KERNEL_LOG_P0;
+    const float poly_[] = {
+        KERNEL_LOG_P1, KERNEL_LOG_P2, KERNEL_LOG_P3, KERNEL_LOG_P4,
+        KERNEL_LOG_P5, KERNEL_LOG_P6, KERNEL_LOG_P7, KERNEL_LOG_P8
+    };
+    for (float p_ : poly_) {
+        y_ = y_ * m_;
+        y_ = y_ + p_;
+    }
+    y_ = y_ * m_;
+    y_ = y_ * z_;
+    float t_ = e_ * KERNEL_LOG_Q1;
+    y_ = y_ + t_;
+    t_ = z_ * -0.5f;
+    y_ = y_ + t_;
+    float r_ = m_ + y_;
+    t_ = e_ * KERNEL_LOG_Q2;
+    return r_ + t_;
+}
+
+// x in [0, 2pi)
+SD_KERNEL_EXACT
+static inline void sincos_scalar(float x_, float &sin_, float &cos_) {
+    float y_ = x_ * KERNEL_FOPI;
+    int32_t j_ = int32_t(y_);
+    j_ = (j_ + 1) & ~1;
+    y_ = float(j_);
+    uint32_t swap_sin_ = uint32_t(j_ & 4) << 29;
+    uint32_t sign_cos_ = uint32_t(~(j_ - 2) & 4) << 29;
+    bool poly_ = (j_ & 2) == 0;
+    float t_ = y_ * KERNEL_DP1;
+    x_ = x_ - t_;
+    t_ = y_ * KERNEL_DP2;
+    x_ = x_ - t_;
+    t_ = y_ * KERNEL_DP3;
+    x_ = x_ - t_;
+    float z_ = x_ * x_;
+    float yc_ = KERNEL_COS_P0;
+    yc_ = yc_ * z_;
+    yc_ = yc_ + KERNEL_COS_P1;
+    yc_ = yc_ * z_;
+    yc_ = yc_ + KERNEL_COS_P2;
+    yc_ = yc_ * z_;
+    yc_ = yc_ * z_;
+    t_ = z_ * 0.5f;
+    yc_ = yc_ - t_;
+    yc_ = yc_ + 1.0f;
+    float ys_ = KERNEL_SIN_P0;
+    ys_ = ys_ * z_;
+    ys_ = ys_ + KERNEL_SIN_P1;
+    ys_ = ys_ * z_;
+    ys_ = ys_ + KERNEL_SIN_P2;
+    ys_ = ys_ * z_;
+    ys_ = ys_ * x_;
+    ys_ = ys_ + x_;
+    sin_ = bits_as_float(float_as_bits(poly_ ? ys_ : yc_) ^ swap_sin_);
+    cos_ = bits_as_float(float_as_bits(poly_ ? yc_ : ys_) ^ sign_cos_);
+}
+
+SD_KERNEL_EXACT
+static void box_muller_scalar(const uint32_t* bits_, float* out_, long size_) {
+    for (long g = 0; g + KERNEL_BOX_MULLER_GROUP <= size_; g += KERNEL_BOX_MULLER_GROUP) {
+        for (long i = g; i < g + KERNEL_BOX_MULLER_HALF; ++i) {
+            float u1_ = float((bits_[i] >> 8) + 1) * KERNEL_INV_2_24;                           // (0, 1]
+            float u2_ = float(bits_[i + KERNEL_BOX_MULLER_HALF] >> 8) * KERNEL_INV_2_24;        // [0, 1)
+            float radius_ = std::sqrt(log_scalar(u1_) * -2.0f);
+            float sin_, cos_;
+            sincos_scalar(u2_ * KERNEL_TWO_PI, sin_, cos_);
+            out_[i] = radius_ * cos_;
+            out_[i + KERNEL_BOX_MULLER_HALF] = radius_ * sin_;
+        }
+    }
+}
+
+SD_KERNEL_EXACT
+static void pixels_to_planar_scalar(
+    const uint8_t* pixels_, int channels_, float scale_, float offset_, float* planar_, long plane_size_, long count_
+) {
+    int planes_ = min(channels_, KERNEL_PIXEL_PLANES);
+    for (int c = 0; c < planes_; ++c) {
+        float* plane_ = planar_ + c * plane_size_;
+        for (long i = 0; i < count_; ++i) { plane_[i] = float(pixels_[i * channels_ + c]) * scale_ + offset_; }
+    }
+}
+
+SD_KERNEL_EXACT
+static void planar_to_pixels_scalar(
+    const float* planar_, long plane_size_, float scale_, float offset_, uint8_t* pixels_, int channels_, long count_
+) {
+    int planes_ = min(channels_, KERNEL_PIXEL_PLANES);
+    for (long i = 0; i < count_; ++i) {
+        uint8_t* pixel_ = pixels_ + i * channels_;
+        for (int c = 0; c < planes_; ++c) {
+            float value_ = min(max(planar_[c * plane_size_ + i] * scale_ + offset_, 0.0f), KERNEL_PIXEL_MAX);
+            pixel_[c] = uint8_t(value_ + 0.5f);
+        }
+        for (int c = planes_; c < channels_; ++c) { pixel_[c] = uint8_t(KERNEL_PIXEL_MAX); }
+    }
+}
+
+#ifdef SD_KERNEL_X86
+/* AVX2 ===================================================================*/
+SD_KERNEL_TARGET_AVX2
+static void axpby_avx2(float a_, const float* x_, float b_, const float* y_, float* out_, long size_) {
+    __m256 va_ = _mm256_set1_ps(a_);
+    __m256 vb_ = _mm256_set1_ps(b_);
+    long i = 0;
+    for (; i + 8 <= size_; i += 8) {
+        __m256 vy_ = _mm256_mul_ps(vb_, _mm256_loadu_ps(y_ + i));
+        _mm256_storeu_ps(out_ + i, _mm256_fmadd_ps(va_, _mm256_loadu_ps(x_ + i), vy_));
+    }
+    axpby_scalar(a_, x_ + i, b_, y_ + i, out_ + i, size_ - i);
+}
+
+SD_KERNEL_TARGET_AVX2
+static void clamp_affine_avx2(
+    const float* x_, float scale_, float offset_, float lower_, float upper_, float* out_, long size_
+) {
+    __m256 vs_ = _mm256_set1_ps(scale_);
+    __m256 vo_ = _mm256_set1_ps(offset_);
+    __m256 vl_ = _mm256_set1_ps(lower_);
+    __m256 vu_ = _mm256_set1_ps(upper_);
+    long i = 0;
+    for (; i + 8 <= size_; i += 8) {
+        __m256 v_ = _mm256_fmadd_ps(_mm256_loadu_ps(x_ + i), vs_, vo_);
+        _mm256_storeu_ps(out_ + i, _mm256_min_ps(_mm256_max_ps(v_, vl_), vu_));
+    }
+    clamp_affine_scalar(x_ + i, scale_, offset_, lower_, upper_, out_ + i, size_ - i);
+}
+
+SD_KERNEL_TARGET_AVX2
+static void weighted_sum_avx2(const float* const* inputs_, const float* weights_, int count_, float* out_, long size_) {
+    long i = 0;
+    for (; i + 8 <= size_; i += 8) {
+        __m256 sum_ = _mm256_setzero_ps();
+        for (int k = 0; k < count_; ++k) {
+            sum_ = _mm256_fmadd_ps(_mm256_set1_ps(weights_[k]), _mm256_loadu_ps(inputs_[k] + i), sum_);
+        }
+        _mm256_storeu_ps(out_ + i, sum_);
+    }
+    for (; i < size_; ++i) {
+        float sum_ = 0.0f;
+        for (int k = 0; k < count_; ++k) { sum_ += weights_[k] * inputs_[k][i]; }
+        out_[i] = sum_;
+    }
+}
+
+SD_KERNEL_TARGET_AVX2
+static void cfg_combine_avx2(const float* negative_, const float* positive_, float scale_, float* out_, long size_) {
+    __m256 vs_ = _mm256_set1_ps(scale_);
+    long i = 0;
+    for (; i + 8 <= size_; i += 8) {
+        __m256 vn_ = _mm256_loadu_ps(negative_ + i);
+        __m256 vd_ = _mm256_sub_ps(_mm256_loadu_ps(positive_ + i), vn_);
+        _mm256_storeu_ps(out_ + i, _mm256_fmadd_ps(vs_, vd_, vn_));
+    }
+    cfg_combine_scalar(negative_ + i, positive_ + i, scale_, out_ + i, size_ - i);
+}
+
+SD_KERNEL_TARGET_AVX2
+static float reduce_sum_avx2(const float* x_, long size_) {
+    __m256 sum_ = _mm256_setzero_ps();
+    long i = 0;
+    for (; i + 8 <= size_; i += 8) {
+        sum_ = _mm256_add_ps(sum_, _mm256_loadu_ps(x_ + i));
+    }
+    __m128 half_ = _mm_add_ps(_mm256_castps256_ps128(sum_), _mm256_extractf128_ps(sum_, 1));
+    half_ = _mm_add_ps(half_, _mm_movehl_ps(half_, half_));
+    half_ = _mm_add_ss(half_, _mm_shuffle_ps(half_, half_, 0x1));
+    return _mm_cvtss_f32(half_) + reduce_sum_scalar(x_ + i, size_ - i);
+}
+
+SD_KERNEL_TARGET_AVX2 SD_KERNEL_EXACT
+static inline __m256 log_avx2(__m256 x_) {
+    const __m256 one_ = _mm256_set1_ps(1.0f);
+    __m256i xi_ = _mm256_castps_si256(x_);
+    __m256 e_ = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(xi_, 23), _mm256_set1_epi32(126)));
+    __m256 m_ = _mm256_castsi256_ps(_mm256_or_si256(
+        _mm256_and_si256(xi_, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F000000)
+    ));
+    __m256 low_ = _mm256_cmp_ps(m_, _mm256_set1_ps(KERNEL_SQRTHF), _CMP_LT_OQ);
+    __m256 tmp_ = _mm256_and_ps(m_, low_);
+    m_ = _mm256_sub_ps(m_, one_);
+    e_ = _mm256_sub_ps(e_, _mm256_and_ps(one_, low_));
+    m_ = _mm256_add_ps(m_, tmp_);
+    __m256 z_ = _mm256_mul_ps(m_, m_);
+    __m256 y_ = _mm256_set1_ps(KERNEL_LOG_P0);
+    const float poly_[] = {
+        KERNEL_LOG_P1, KERNEL_LOG_P2, KERNEL_LOG_P3, KERNEL_LOG_P4,
+        KERNEL_LOG_P5, KERNEL_LOG_P6, KERNEL_LOG_P7, KERNEL_LOG_P8
+    };
+    for (float p_ : poly_) {
+        y_ = _mm256_add_ps(_mm256_mul_ps(y_, m_), _mm256_set1_ps(p_));
+    }
+    y_ = _mm256_mul_ps(_mm256_mul_ps(y_, m_), z_);
+    y_ = _mm256_add_ps(y_, _mm256_mul_ps(e_, _mm256_set1_ps(KERNEL_LOG_Q1)));
+    y_ = _mm256_add_ps(y_, _mm256_mul_ps(z_, _mm256_set1_ps(-0.5f)));
+    __m256 r_ = _mm256_add_ps(m_, y_);
+    return _mm256_add_ps(r_, _mm256_mul_ps(e_, _mm256_set1_ps(KERNEL_LOG_Q2)));
+}
+
+SD_KERNEL_TARGET_AVX2 SD_KERNEL_EXACT
+static inline void sincos_avx2(__m256 x_, __m256 &sin_, __m256 &cos_) {
+    __m256i j_ = _mm256_cvttps_epi32(_mm256_mul_ps(x_, _mm256_set1_ps(KERNEL_FOPI)));
+    j_ = _mm256_and_si256(_mm256_add_epi32(j_, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+    __m256 y_ = _mm256_cvtepi32_ps(j_);
+    __m256 swap_sin_ = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j_, _mm256_set1_epi32(4)), 29));
+    __m256 sign_cos_ = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_andnot_si256(_mm256_sub_epi32(j_, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29
+    ));
+    __m256 poly_ = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+        _mm256_and_si256(j_, _mm256_set1_epi32(2)), _mm256_setzero_si256()
+    ));
+    x_ = _mm256_sub_ps(x_, _mm256_mul_ps(y_, _mm256_set1_ps(KERNEL_DP1)));
+    x_ = _mm256_sub_ps(x_, _mm256_mul_ps(y_, _mm256_set1_ps(KERNEL_DP2)));
+    x_ = _mm256_sub_ps(x_, _mm256_mul_ps(y_, _mm256_set1_ps(KERNEL_DP3)));
+    __m256 z_ = _mm256_mul_ps(x_, x_);
+    __m256 yc_ = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(KERNEL_COS_P0), z_), _mm256_set1_ps(KERNEL_COS_P1));
+    yc_ = _mm256_add_ps(_mm256_mul_ps(yc_, z_), _mm256_set1_ps(KERNEL_COS_P2));
+    yc_ = _mm256_mul_ps(_mm256_mul_ps(yc_, z_), z_);
+    yc_ = _mm256_sub_ps(yc_, _mm256_mul_ps(z_, _mm256_set1_ps(0.5f)));
+    yc_ = _mm256_add_ps(yc_, _mm256_set1_ps(1.0f));
+    __m256 ys_ = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(KERNEL_SIN_P0), z_), _mm256_set1_ps(KERNEL_SIN_P1));
+    ys_ = _mm256_add_ps(_mm256_mul_ps(ys_, z_), _mm256_set1_ps(KERNEL_SIN_P2));
+    ys_ = _mm256_mul_ps(_mm256_mul_ps(ys_, z_), x_);
+    ys_ = _mm256_add_ps(ys_, x_);
+    sin_ = _mm256_xor_ps(_mm256_blendv_ps(yc_, ys_, poly_), swap_sin_);
+    cos_ = _mm256_xor_ps(_mm256_blendv_ps(ys_, yc_, poly_), sign_cos_);
+}
+
+SD_KERNEL_TARGET_AVX2 SD_KERNEL_EXACT
+static void box_muller_avx2(const uint32_t* bits_, float* out_, long size_) {
+    const __m256 scale_ = _mm256_set1_ps(KERNEL_INV_2_24);
+    for (long g = 0; g + KERNEL_BOX_MULLER_GROUP <= size_; g += KERNEL_BOX_MULLER_GROUP) {
+        for (long i = g; i < g + KERNEL_BOX_MULLER_HALF; i += 8) {
+            __m256i b1_ = _mm256_loadu_si256((const __m256i*) (bits_ + i));
+            __m256i b2_ = _mm256_loadu_si256((const __m256i*) (bits_ + i + KERNEL_BOX_MULLER_HALF));
+            __m256 u1_ = _mm256_mul_ps(_mm256_cvtepi32_ps(
+                _mm256_add_epi32(_mm256_srli_epi32(b1_, 8), _mm256_set1_epi32(1))
+            ), scale_);
+            __m256 u2_ = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(b2_, 8)), scale_);
+            __m256 radius_ = _mm256_sqrt_ps(_mm256_mul_ps(log_avx2(u1_), _mm256_set1_ps(-2.0f)));
+            __m256 sin_, cos_;
+            sincos_avx2(_mm256_mul_ps(u2_, _mm256_set1_ps(KERNEL_TWO_PI)), sin_, cos_);
+            _mm256_storeu_ps(out_ + i, _mm256_mul_ps(radius_, cos_));
+            _mm256_storeu_ps(out_ + i + KERNEL_BOX_MULLER_HALF, _mm256_mul_ps(radius_, sin_));
+        }
+    }
+}
+
+// 8 pixels per round, unpacked to one 32-bit slot each (R | G << 8 | B << 16), 3-channel input read
+// as bytes [0, 16) & [8, 24) in two lanes so nothing past the 8th pixel is touched
+SD_KERNEL_TARGET_AVX2 SD_KERNEL_EXACT
+static void pixels_to_planar_avx2(
+    const uint8_t* pixels_, int channels_, float scale_, float offset_, float* planar_, long plane_size_, long count_
+) {
+    if (channels_ != 3 && channels_ != 4) {
+        pixels_to_planar_scalar(pixels_, channels_, scale_, offset_, planar_, plane_size_, count_);
+        return;
+    }
+    const __m256i expand_ = _mm256_setr_epi8(
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+        4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1
+    );
+    const __m256i byte_ = _mm256_set1_epi32(0xFF);
+    __m256 vs_ = _mm256_set1_ps(scale_);
+    __m256 vo_ = _mm256_set1_ps(offset_);
+    float* r_ = planar_;
+    float* g_ = planar_ + plane_size_;
+    float* b_ = planar_ + 2 * plane_size_;
+    long i = 0;
+    for (; i + 8 <= count_; i += 8) {
+        const uint8_t* at_ = pixels_ + i * channels_;
+        __m256i px_;
+        if (channels_ == 4) {
+            px_ = _mm256_loadu_si256((const __m256i*) at_);
+        } else {
+            __m256i raw_ = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*) at_)),
+                _mm_loadu_si128((const __m128i*) (at_ + 8)), 1
+            );
+            px_ = _mm256_shuffle_epi8(raw_, expand_);
+        }
+        __m256 vr_ = _mm256_cvtepi32_ps(_mm256_and_si256(px_, byte_));
+        __m256 vg_ = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px_, 8), byte_));
+        __m256 vb_ = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px_, 16), byte_));
+        _mm256_storeu_ps(r_ + i, _mm256_add_ps(_mm256_mul_ps(vr_, vs_), vo_));
+        _mm256_storeu_ps(g_ + i, _mm256_add_ps(_mm256_mul_ps(vg_, vs_), vo_));
+        _mm256_storeu_ps(b_ + i, _mm256_add_ps(_mm256_mul_ps(vb_, vs_), vo_));
+    }
+    pixels_to_planar_scalar(pixels_ + i * channels_, channels_, scale_, offset_, planar_ + i, plane_size_, count_ - i);
+}
+
+SD_KERNEL_TARGET_AVX2 SD_KERNEL_EXACT
+static inline __m256i quantize_avx2(const float* x_, __m256 scale_, __m256 offset_) {
+    __m256 v_ = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(x_), scale_), offset_);
+    v_ = _mm256_min_ps(_mm256_max_ps(v_, _mm256_setzero_ps()), _mm256_set1_ps(KERNEL_PIXEL_MAX));
+    return _mm256_cvttps_epi32(_mm256_add_ps(v_, _mm256_set1_ps(0.5f)));
+}
+
+// reverse of pixels_to_planar_avx2, 3-channel output compacted per lane then stored as 16 + 8 + 4 bytes
+SD_KERNEL_TARGET_AVX2 SD_KERNEL_EXACT
+static void planar_to_pixels_avx2(
+    const float* planar_, long plane_size_, float scale_, float offset_, uint8_t* pixels_, int channels_, long count_
+) {
+    if (channels_ != 3 && channels_ != 4) {
+        planar_to_pixels_scalar(planar_, plane_size_, scale_, offset_, pixels_, channels_, count_);
+        return;
+    }
+    const __m256i compact_ = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1
+    );
+    const __m256i alpha_ = _mm256_set1_epi32(channels_ == 4 ? int(0xFF000000u) : 0);
+    __m256 vs_ = _mm256_set1_ps(scale_);
+    __m256 vo_ = _mm256_set1_ps(offset_);
+    const float* r_ = planar_;
+    const float* g_ = planar_ + plane_size_;
+    const float* b_ = planar_ + 2 * plane_size_;
+    long i = 0;
+    for (; i + 8 <= count_; i += 8) {
+        __m256i px_ = _mm256_or_si256(
+            _mm256_or_si256(quantize_avx2(r_ + i, vs_, vo_), _mm256_slli_epi32(quantize_avx2(g_ + i, vs_, vo_), 8)),
+            _mm256_or_si256(_mm256_slli_epi32(quantize_avx2(b_ + i, vs_, vo_), 16), alpha_)
+        );
+        uint8_t* at_ = pixels_ + i * channels_;
+        if (channels_ == 4) {
+            _mm256_storeu_si256((__m256i*) at_, px_);
+        } else {
+            __m256i packed_ = _mm256_shuffle_epi8(px_, compact_);
+            __m128i high_ = _mm256_extracti128_si256(packed_, 1);
+            int tail_ = _mm_extract_epi32(high_, 2);
+            _mm_storeu_si128((__m128i*) at_, _mm256_castsi256_si128(packed_));    // last 4 bytes rewritten below
+            _mm_storel_epi64((__m128i*) (at_ + 12), high_);
+            memcpy(at_ + 20, &tail_, sizeof(int));
+        }
+    }
+    planar_to_pixels_scalar(planar_ + i, plane_size_, scale_, offset_, pixels_ + i * channels_, channels_, count_ - i);
+}
+
+/* AVX-512 ================================================================*/
+SD_KERNEL_TARGET_AVX512
+static void axpby_avx512(float a_, const float* x_, float b_, const float* y_, float* out_, long size_) {
+    __m512 va_ = _mm512_set1_ps(a_);
+    __m512 vb_ = _mm512_set1_ps(b_);
+    for (long i = 0; i < size_; i += 16) {
+        __mmask16 m_ = (size_ - i >= 16) ? __mmask16(0xFFFF) : __mmask16((1u << (size_ - i)) - 1);
+        __m512 vy_ = _mm512_mul_ps(vb_, _mm512_maskz_loadu_ps(m_, y_ + i));
+        _mm512_mask_storeu_ps(out_ + i, m_, _mm512_fmadd_ps(va_, _mm512_maskz_loadu_ps(m_, x_ + i), vy_));
+    }
+}
+
+SD_KERNEL_TARGET_AVX512
+static void clamp_affine_avx512(
+    const float* x_, float scale_, float offset_, float lower_, float upper_, float* out_, long size_
+) {
+    __m512 vs_ = _mm512_set1_ps(scale_);
+    __m512 vo_ = _mm512_set1_ps(offset_);
+    __m512 vl_ = _mm512_set1_ps(lower_);
+    __m512 vu_ = _mm512_set1_ps(upper_);
+    for (long i = 0; i < size_; i += 16) {
+        __mmask16 m_ = (size_ - i >= 16) ? __mmask16(0xFFFF) : __mmask16((1u << (size_ - i)) - 1);
+        __m512 v_ = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m_, x_ + i), vs_, vo_);
+        _mm512_mask_storeu_ps(out_ + i, m_, _mm512_min_ps(_mm512_max_ps(v_, vl_), vu_));
+    }
+}
+
+SD_KERNEL_TARGET_AVX512
+static void weighted_sum_avx512(const float* const* inputs_, const float* weights_, int count_, float* out_, long size_) {
+    for (long i = 0; i < size_; i += 16) {
+        __mmask16 m_ = (size_ - i >= 16) ? __mmask16(0xFFFF) : __mmask16((1u << (size_ - i)) - 1);
+        __m512 sum_ = _mm512_setzero_ps();
+        for (int k = 0; k < count_; ++k) {
+            sum_ = _mm512_fmadd_ps(_mm512_set1_ps(weights_[k]), _mm512_maskz_loadu_ps(m_, inputs_[k] + i), sum_);
+        }
+        _mm512_mask_storeu_ps(out_ + i, m_, sum_);
+    }
+}
+
+SD_KERNEL_TARGET_AVX512
+static void cfg_combine_avx512(const float* negative_, const float* positive_, float scale_, float* out_, long size_) {
+    __m512 vs_ = _mm512_set1_ps(scale_);
+    for (long i = 0; i < size_; i += 16) {
+        __mmask16 m_ = (size_ - i >= 16) ? __mmask16(0xFFFF) : __mmask16((1u << (size_ - i)) - 1);
+        __m512 vn_ = _mm512_maskz_loadu_ps(m_, negative_ + i);
+        __m512 vd_ = _mm512_sub_ps(_mm512_maskz_loadu_ps(m_, positive_ + i), vn_);
+        _mm512_mask_storeu_ps(out_ + i, m_, _mm512_fmadd_ps(vs_, vd_, vn_));
+    }
+}
+
+SD_KERNEL_TARGET_AVX512
+static float reduce_sum_avx512(const float* x_, long size_) {
+    __m512 sum_ = _mm512_setzero_ps();
+    for (long i = 0; i < size_; i += 16) {
+        __mmask16 m_ = (size_ - i >= 16) ? __mmask16(0xFFFF) : __mmask16((1u << (size_ - i)) - 1);
+        sum_ = _mm512_add_ps(sum_, _mm512_maskz_loadu_ps(m_, x_ + i));
+    }
+    return _mm512_reduce_add_ps(sum_);
+}
+
+// float and/xor of avx512f only exist on integer lanes, hence the casts
+SD_KERNEL_TARGET_AVX512 SD_KERNEL_EXACT
+static inline __m512 log_avx512(__m512 x_) {
+    const __m512 one_ = _mm512_set1_ps(1.0f);
+    __m512i xi_ = _mm512_castps_si512(x_);
+    __m512 e_ = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(xi_, 23), _mm512_set1_epi32(126)));
+    __m512 m_ = _mm512_castsi512_ps(_mm512_or_si512(
+        _mm512_and_si512(xi_, _mm512_set1_epi32(0x007FFFFF)), _mm512_set1_epi32(0x3F000000)
+    ));
+    __mmask16 low_ = _mm512_cmp_ps_mask(m_, _mm512_set1_ps(KERNEL_SQRTHF), _CMP_LT_OQ);
+    __m512 tmp_ = _mm512_maskz_mov_ps(low_, m_);
+    m_ = _mm512_sub_ps(m_, one_);
+    e_ = _mm512_sub_ps(e_, _mm512_maskz_mov_ps(low_, one_));
+    m_ = _mm512_add_ps(m_, tmp_);
+    __m512 z_ = _mm512_mul_ps(m_, m_);
+    __m512 y_ = _mm512_set1_ps(KERNEL_LOG_P0);
+    const float poly_[] = {
+        KERNEL_LOG_P1, KERNEL_LOG_P2, KERNEL_LOG_P3, KERNEL_LOG_P4,
+        KERNEL_LOG_P5, KERNEL_LOG_P6, KERNEL_LOG_P7, KERNEL_LOG_P8
+    };
+    for (float p_ : poly_) {
+        y_ = _mm512_add_ps(_mm512_mul_ps(y_, m_), _mm512_set1_ps(p_));
+    }
+    y_ = _mm512_mul_ps(_mm512_mul_ps(y_, m_), z_);
+    y_ = _mm512_add_ps(y_, _mm512_mul_ps(e_, _mm512_set1_ps(KERNEL_LOG_Q1)));
+    y_ = _mm512_add_ps(y_, _mm512_mul_ps(z_, _mm512_set1_ps(-0.5f)));
+    __m512 r_ = _mm512_add_ps(m_, y_);
+    return _mm512_add_ps(r_, _mm512_mul_ps(e_, _mm512_set1_ps(KERNEL_LOG_Q2)));
+}
+
+SD_KERNEL_TARGET_AVX512 SD_KERNEL_EXACT
+static inline void sincos_avx512(__m512 x_, __m512 &sin_, __m512 &cos_) {
+    __m512i j_ = _mm512_cvttps_epi32(_mm512_mul_ps(x_, _mm512_set1_ps(KERNEL_FOPI)));
+    j_ = _mm512_and_si512(_mm512_add_epi32(j_, _mm512_set1_epi32(1)), _mm512_set1_epi32(~1));
+    __m512 y_ = _mm512_cvtepi32_ps(j_);
+    __m512i swap_sin_ = _mm512_slli_epi32(_mm512_and_si512(j_, _mm512_set1_epi32(4)), 29);
+    __m512i sign_cos_ = _mm512_slli_epi32(
+        _mm512_andnot_si512(_mm512_sub_epi32(j_, _mm512_set1_epi32(2)), _mm512_set1_epi32(4)), 29
+    );
+    __mmask16 poly_ = _mm512_cmpeq_epi32_mask(_mm512_and_si512(j_, _mm512_set1_epi32(2)), _mm512_setzero_si512());
+    x_ = _mm512_sub_ps(x_, _mm512_mul_ps(y_, _mm512_set1_ps(KERNEL_DP1)));
+    x_ = _mm512_sub_ps(x_, _mm512_mul_ps(y_, _mm512_set1_ps(KERNEL_DP2)));
+    x_ = _mm512_sub_ps(x_, _mm512_mul_ps(y_, _mm512_set1_ps(KERNEL_DP3)));
+    __m512 z_ = _mm512_mul_ps(x_, x_);
+    __m512 yc_ = _mm512_add_ps(_mm512_mul_ps(_mm512_set1_ps(KERNEL_COS_P0), z_), _mm512_set1_ps(KERNEL_COS_P1));
+    yc_ = _mm512_add_ps(_mm512_mul_ps(yc_, z_), _mm512_set1_ps(KERNEL_COS_P2));
+    yc_ = _mm512_mul_ps(_mm512_mul_ps(yc_, z_), z_);
+    yc_ = _mm512_sub_ps(yc_, _mm512_mul_ps(z_, _mm512_set1_ps(0.5f)));
+    yc_ = _mm512_add_ps(yc_, _mm512_set1_ps(1.0f));
+    __m512 ys_ = _mm512_add_ps(_mm512_mul_ps(_mm512_set1_ps(KERNEL_SIN_P0), z_), _mm512_set1_ps(KERNEL_SIN_P1));
+    ys_ = _mm512_add_ps(_mm512_mul_ps(ys_, z_), _mm512_set1_ps(KERNEL_SIN_P2));
+    ys_ = _mm512_mul_ps(_mm512_mul_ps(ys_, z_), x_);
+    ys_ = _mm512_add_ps(ys_, x_);
+    sin_ = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(_mm512_mask_blend_ps(poly_, yc_, ys_)), swap_sin_));
+    cos_ = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(_mm512_mask_blend_ps(poly_, ys_, yc_)), sign_cos_));
+}
+
+SD_KERNEL_TARGET_AVX512 SD_KERNEL_EXACT
+static void box_muller_avx512(const uint32_t* bits_, float* out_, long size_) {
+    const __m512 scale_ = _mm512_set1_ps(KERNEL_INV_2_24);
+    for (long g = 0; g + KERNEL_BOX_MULLER_GROUP <= size_; g += KERNEL_BOX_MULLER_GROUP) {
+        __m512i b1_ = _mm512_loadu_si512((const void*) (bits_ + g));
+        __m512i b2_ = _mm512_loadu_si512((const void*) (bits_ + g + KERNEL_BOX_MULLER_HALF));
+        __m512 u1_ = _mm512_mul_ps(_mm512_cvtepi32_ps(
+            _mm512_add_epi32(_mm512_srli_epi32(b1_, 8), _mm512_set1_epi32(1))
+        ), scale_);
+        __m512 u2_ = _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(b2_, 8)), scale_);
+        __m512 radius_ = _mm512_sqrt_ps(_mm512_mul_ps(log_avx512(u1_), _mm512_set1_ps(-2.0f)));
+        __m512 sin_, cos_;
+        sincos_avx512(_mm512_mul_ps(u2_, _mm512_set1_ps(KERNEL_TWO_PI)), sin_, cos_);
+        _mm512_storeu_ps(out_ + g, _mm512_mul_ps(radius_, cos_));
+        _mm512_storeu_ps(out_ + g + KERNEL_BOX_MULLER_HALF, _mm512_mul_ps(radius_, sin_));
+    }
+}
+
+static KernelLevel detect_level() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info_[4] = {0};
+    __cpuid(info_, 0);
+    if (info_[0] < 7) { return KERNEL_LEVEL_SCALAR; }
+    __cpuid(info_, 1);
+    bool os_avx_ = (info_[2] & (1 << 27)) && (info_[2] & (1 << 28));
+    bool fma_ = (info_[2] & (1 << 12)) != 0;
+    if (!os_avx_) { return KERNEL_LEVEL_SCALAR; }
+    unsigned long long xcr0_ = _xgetbv(0);
+    __cpuidex(info_, 7, 0);
+    bool avx2_ = fma_ && (info_[1] & (1 << 5)) && ((xcr0_ & 0x6) == 0x6);
+    bool avx512_ = (info_[1] & (1 << 16)) && ((xcr0_ & 0xE6) == 0xE6);
+    return avx512_ ? KERNEL_LEVEL_AVX512 : (avx2_ ? KERNEL_LEVEL_AVX2 : KERNEL_LEVEL_SCALAR);
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) { return KERNEL_LEVEL_AVX512; }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) { return KERNEL_LEVEL_AVX2; }
+    return KERNEL_LEVEL_SCALAR;
+#endif
+}
+#endif  // SD_KERNEL_X86
+
+#ifdef SD_KERNEL_NEON
+/* NEON ===================================================================*/
+static void axpby_neon(float a_, const float* x_, float b_, const float* y_, float* out_, long size_) {
+    float32x4_t vb_ = vdupq_n_f32(b_);
+    long i = 0;
+    for (; i + 4 <= size_; i += 4) {
+        float32x4_t vy_ = vmulq_f32(vb_, vld1q_f32(y_ + i));
+        vst1q_f32(out_ + i, vfmaq_n_f32(vy_, vld1q_f32(x_ + i), a_));
+    }
+    axpby_scalar(a_, x_ + i, b_, y_ + i, out_ + i, size_ - i);
+}
+
+static void clamp_affine_neon(
+    const float* x_, float scale_, float offset_, float lower_, float upper_, float* out_, long size_
+) {
+    float32x4_t vo_ = vdupq_n_f32(offset_);
+    float32x4_t vl_ = vdupq_n_f32(lower_);
+    float32x4_t vu_ = vdupq_n_f32(upper_);
+    long i = 0;
+    for (; i + 4 <= size_; i += 4) {
+        float32x4_t v_ = vfmaq_n_f32(vo_, vld1q_f32(x_ + i), scale_);
+        vst1q_f32(out_ + i, vminq_f32(vmaxq_f32(v_, vl_), vu_));
+    }
+    clamp_affine_scalar(x_ + i, scale_, offset_, lower_, upper_, out_ + i, size_ - i);
+}
+
+static void weighted_sum_neon(const float* const* inputs_, const float* weights_, int count_, float* out_, long size_) {
+    long i = 0;
+    for (; i + 4 <= size_; i += 4) {
+        float32x4_t sum_ = vdupq_n_f32(0.0f);
+        for (int k = 0; k < count_; ++k) {
+            sum_ = vfmaq_n_f32(sum_, vld1q_f32(inputs_[k] + i), weights_[k]);
+        }
+        vst1q_f32(out_ + i, sum_);
+    }
+    for (; i < size_; ++i) {
+        float sum_ = 0.0f;
+        for (int k = 0; k < count_; ++k) { sum_ += weights_[k] * inputs_[k][i]; }
+        out_[i] = sum_;
+    }
+}
+
+static void cfg_combine_neon(const float* negative_, const float* positive_, float scale_, float* out_, long size_) {
+    long i = 0;
+    for (; i + 4 <= size_; i += 4) {
+        float32x4_t vn_ = vld1q_f32(negative_ + i);
+        float32x4_t vd_ = vsubq_f32(vld1q_f32(positive_ + i), vn_);
+        vst1q_f32(out_ + i, vfmaq_n_f32(vn_, vd_, scale_));
+    }
+    cfg_combine_scalar(negative_ + i, positive_ + i, scale_, out_ + i, size_ - i);
+}
+
+static float reduce_sum_neon(const float* x_, long size_) {
+    float32x4_t sum_ = vdupq_n_f32(0.0f);
+    long i = 0;
+    for (; i + 4 <= size_; i += 4) {
+        sum_ = vaddq_f32(sum_, vld1q_f32(x_ + i));
+    }
+    return vaddvq_f32(sum_) + reduce_sum_scalar(x_ + i, size_ - i);
+}
+
+SD_KERNEL_EXACT
+static inline float32x4_t log_neon(float32x4_t x_) {
+    const float32x4_t one_ = vdupq_n_f32(1.0f);
+    uint32x4_t xi_ = vreinterpretq_u32_f32(x_);
+    float32x4_t e_ = vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(xi_, 23)), vdupq_n_s32(126)));
+    float32x4_t m_ = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(xi_, vdupq_n_u32(0x007FFFFF)), vdupq_n_u32(0x3F000000)));
+    uint32x4_t low_ = vcltq_f32(m_, vdupq_n_f32(KERNEL_SQRTHF));
+    float32x4_t tmp_ = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(m_), low_));
+    m_ = vsubq_f32(m_, one_);
+    e_ = vsubq_f32(e_, vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(one_), low_)));
+    m_ = vaddq_f32(m_, tmp_);
+    float32x4_t z_ = vmulq_f32(m_, m_);
+    float32x4_t y_ = vdupq_n_f32(KERNEL_LOG_P0);
+    const float poly_[] = {
+        KERNEL_LOG_P1, KERNEL_LOG_P2, KERNEL_LOG_P3, KERNEL_LOG_P4,
+        KERNEL_LOG_P5, KERNEL_LOG_P6, KERNEL_LOG_P7, KERNEL_LOG_P8
+    };
+    for (float p_ : poly_) {
+        y_ = vaddq_f32(vmulq_f32(y_, m_), vdupq_n_f32(p_));
+    }
+    y_ = vmulq_f32(vmulq_f32(y_, m_), z_);
+    y_ = vaddq_f32(y_, vmulq_n_f32(e_, KERNEL_LOG_Q1));
+    y_ = vaddq_f32(y_, vmulq_n_f32(z_, -0.5f));
+    float32x4_t r_ = vaddq_f32(m_, y_);
+    return vaddq_f32(r_, vmulq_n_f32(e_, KERNEL_LOG_Q2));
+}
+
+SD_KERNEL_EXACT
+static inline void sincos_neon(float32x4_t x_, float32x4_t &sin_, float32x4_t &cos_) {
+    int32x4_t j_ = vcvtq_s32_f32(vmulq_n_f32(x_, KERNEL_FOPI));
+    j_ = vandq_s32(vaddq_s32(j_, vdupq_n_s32(1)), vdupq_n_s32(~1));
+    float32x4_t y_ = vcvtq_f32_s32(j_);
+    uint32x4_t swap_sin_ = vshlq_n_u32(vreinterpretq_u32_s32(vandq_s32(j_, vdupq_n_s32(4))), 29);
+    uint32x4_t sign_cos_ = vshlq_n_u32(vreinterpretq_u32_s32(
+        vbicq_s32(vdupq_n_s32(4), vsubq_s32(j_, vdupq_n_s32(2)))
+    ), 29);
+    uint32x4_t poly_ = vceqq_s32(vandq_s32(j_, vdupq_n_s32(2)), vdupq_n_s32(0));
+    x_ = vsubq_f32(x_, vmulq_n_f32(y_, KERNEL_DP1));
+    x_ = vsubq_f32(x_, vmulq_n_f32(y_, KERNEL_DP2));
+    x_ = vsubq_f32(x_, vmulq_n_f32(y_, KERNEL_DP3));
+    float32x4_t z_ = vmulq_f32(x_, x_);
+    float32x4_t yc_ = vaddq_f32(vmulq_f32(vdupq_n_f32(KERNEL_COS_P0), z_), vdupq_n_f32(KERNEL_COS_P1));
+    yc_ = vaddq_f32(vmulq_f32(yc_, z_), vdupq_n_f32(KERNEL_COS_P2));
+    yc_ = vmulq_f32(vmulq_f32(yc_, z_), z_);
+    yc_ = vsubq_f32(yc_, vmulq_n_f32(z_, 0.5f));
+    yc_ = vaddq_f32(yc_, vdupq_n_f32(1.0f));
+    float32x4_t ys_ = vaddq_f32(vmulq_f32(vdupq_n_f32(KERNEL_SIN_P0), z_), vdupq_n_f32(KERNEL_SIN_P1));
+    ys_ = vaddq_f32(vmulq_f32(ys_, z_), vdupq_n_f32(KERNEL_SIN_P2));
+    ys_ = vmulq_f32(vmulq_f32(ys_, z_), x_);
+    ys_ = vaddq_f32(ys_, x_);
+    sin_ = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(vbslq_f32(poly_, ys_, yc_)), swap_sin_));
+    cos_ = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(vbslq_f32(poly_, yc_, ys_)), sign_cos_));
+}
+
+SD_KERNEL_EXACT
+static void box_muller_neon(const uint32_t* bits_, float* out_, long size_) {
+    for (long g = 0; g + KERNEL_BOX_MULLER_GROUP <= size_; g += KERNEL_BOX_MULLER_GROUP) {
+        for (long i = g; i < g + KERNEL_BOX_MULLER_HALF; i += 4) {
+            uint32x4_t b1_ = vld1q_u32(bits_ + i);
+            uint32x4_t b2_ = vld1q_u32(bits_ + i + KERNEL_BOX_MULLER_HALF);
+            float32x4_t u1_ = vmulq_n_f32(vcvtq_f32_u32(vaddq_u32(vshrq_n_u32(b1_, 8), vdupq_n_u32(1))), KERNEL_INV_2_24);
+            float32x4_t u2_ = vmulq_n_f32(vcvtq_f32_u32(vshrq_n_u32(b2_, 8)), KERNEL_INV_2_24);
+            float32x4_t radius_ = vsqrtq_f32(vmulq_n_f32(log_neon(u1_), -2.0f));
+            float32x4_t sin_, cos_;
+            sincos_neon(vmulq_n_f32(u2_, KERNEL_TWO_PI), sin_, cos_);
+            vst1q_f32(out_ + i, vmulq_f32(radius_, cos_));
+            vst1q_f32(out_ + i + KERNEL_BOX_MULLER_HALF, vmulq_f32(radius_, sin_));
+        }
+    }
+}
+SD_KERNEL_EXACT
+static void pixels_to_planar_neon(
+    const uint8_t* pixels_, int channels_, float scale_, float offset_, float* planar_, long plane_size_, long count_
+) {
+    if (channels_ != 3 && channels_ != 4) {
+        pixels_to_planar_scalar(pixels_, channels_, scale_, offset_, planar_, plane_size_, count_);
+        return;
+    }
+    float32x4_t vo_ = vdupq_n_f32(offset_);
+    long i = 0;
+    for (; i + 8 <= count_; i += 8) {
+        uint8x8_t planes_[KERNEL_PIXEL_PLANES];
+        if (channels_ == 4) {
+            uint8x8x4_t px_ = vld4_u8(pixels_ + i * 4);
+            planes_[0] = px_.val[0]; planes_[1] = px_.val[1]; planes_[2] = px_.val[2];
+        } else {
+            uint8x8x3_t px_ = vld3_u8(pixels_ + i * 3);
+            planes_[0] = px_.val[0]; planes_[1] = px_.val[1]; planes_[2] = px_.val[2];
+        }
+        for (int c = 0; c < KERNEL_PIXEL_PLANES; ++c) {
+            uint16x8_t wide_ = vmovl_u8(planes_[c]);
+            float32x4_t lo_ = vcvtq_f32_u32(vmovl_u16(vget_low_u16(wide_)));
+            float32x4_t hi_ = vcvtq_f32_u32(vmovl_u16(vget_high_u16(wide_)));
+            vst1q_f32(planar_ + c * plane_size_ + i, vaddq_f32(vmulq_n_f32(lo_, scale_), vo_));
+            vst1q_f32(planar_ + c * plane_size_ + i + 4, vaddq_f32(vmulq_n_f32(hi_, scale_), vo_));
+        }
+    }
+    pixels_to_planar_scalar(pixels_ + i * channels_, channels_, scale_, offset_, planar_ + i, plane_size_, count_ - i);
+}
+
+SD_KERNEL_EXACT
+static inline uint8x8_t quantize_neon(const float* x_, float scale_, float32x4_t offset_) {
+    const float32x4_t lower_ = vdupq_n_f32(0.0f);
+    const float32x4_t upper_ = vdupq_n_f32(KERNEL_PIXEL_MAX);
+    const float32x4_t half_ = vdupq_n_f32(0.5f);
+    float32x4_t lo_ = vaddq_f32(vmulq_n_f32(vld1q_f32(x_), scale_), offset_);
+    float32x4_t hi_ = vaddq_f32(vmulq_n_f32(vld1q_f32(x_ + 4), scale_), offset_);
+    lo_ = vaddq_f32(vminq_f32(vmaxq_f32(lo_, lower_), upper_), half_);
+    hi_ = vaddq_f32(vminq_f32(vmaxq_f32(hi_, lower_), upper_), half_);
+    return vmovn_u16(vcombine_u16(vmovn_u32(vcvtq_u32_f32(lo_)), vmovn_u32(vcvtq_u32_f32(hi_))));
+}
+
+SD_KERNEL_EXACT
+static void planar_to_pixels_neon(
+    const float* planar_, long plane_size_, float scale_, float offset_, uint8_t* pixels_, int channels_, long count_
+) {
+    if (channels_ != 3 && channels_ != 4) {
+        planar_to_pixels_scalar(planar_, plane_size_, scale_, offset_, pixels_, channels_, count_);
+        return;
+    }
+    float32x4_t vo_ = vdupq_n_f32(offset_);
+    long i = 0;
+    for (; i + 8 <= count_; i += 8) {
+        uint8x8_t r_ = quantize_neon(planar_ + i, scale_, vo_);
+        uint8x8_t g_ = quantize_neon(planar_ + plane_size_ + i, scale_, vo_);
+        uint8x8_t b_ = quantize_neon(planar_ + 2 * plane_size_ + i, scale_, vo_);
+        if (channels_ == 4) {
+            uint8x8x4_t px_ = {{r_, g_, b_, vdup_n_u8(uint8_t(KERNEL_PIXEL_MAX))}};
+            vst4_u8(pixels_ + i * 4, px_);
+        } else {
+            uint8x8x3_t px_ = {{r_, g_, b_}};
+            vst3_u8(pixels_ + i * 3, px_);
+        }
+    }
+    planar_to_pixels_scalar(planar_ + i, plane_size_, scale_, offset_, pixels_ + i * channels_, channels_, count_ - i);
+}
+#endif  // SD_KERNEL_NEON
+
+static KernelTable resolve_table() {
+#if defined(SD_KERNEL_X86)
+    switch (detect_level()) {
+        case KERNEL_LEVEL_AVX512: {
+            // pixel conversion is byte shuffling bound, 256-bit variants kept (avx512f cpus all have avx2)
+            return {KERNEL_LEVEL_AVX512, axpby_avx512, clamp_affine_avx512, weighted_sum_avx512,
+                    cfg_combine_avx512, reduce_sum_avx512, box_muller_avx512,
+                    pixels_to_planar_avx2, planar_to_pixels_avx2};
+        }
+        case KERNEL_LEVEL_AVX2: {
+            return {KERNEL_LEVEL_AVX2, axpby_avx2, clamp_affine_avx2, weighted_sum_avx2,
+                    cfg_combine_avx2, reduce_sum_avx2, box_muller_avx2,
+                    pixels_to_planar_avx2, planar_to_pixels_avx2};
+        }
+        default: break;
+    }
+#elif defined(SD_KERNEL_NEON)
+    return {KERNEL_LEVEL_NEON, axpby_neon, clamp_affine_neon, weighted_sum_neon,
+            cfg_combine_neon, reduce_sum_neon, box_muller_neon,
+            pixels_to_planar_neon, planar_to_pixels_neon};
+#endif
+    return {KERNEL_LEVEL_SCALAR, axpby_scalar, clamp_affine_scalar, weighted_sum_scalar,
+            cfg_combine_scalar, reduce_sum_scalar, box_muller_scalar,
+            pixels_to_planar_scalar, planar_to_pixels_scalar};
+}
+
+static const KernelTable& table() {
+    static const KernelTable table_ = resolve_table();
+    return table_;
+}
+
+} // namespace kernels
+
+/**
+ * @details Typed entry of kernels, float goes through dispatched SIMD table, other types (rarely
+ *          used, int64 timesteps etc.) fall back to plain loops.
+ */
+class KernelHelper {
+public:
+    static KernelLevel level() {
+        return kernels::table().level;
+    }
+
+    template<class T>
+    static void axpby(float a_, const T* x_, float b_, const T* y_, T* out_, long size_) {
+        if constexpr (std::is_same<T, float>::value) {
+            kernels::table().axpby(a_, x_, b_, y_, out_, size_);
+        } else {
+            for (long i = 0; i < size_; ++i) { out_[i] = T(a_ * x_[i] + b_ * y_[i]); }
+        }
+    }
+
+    template<class T>
+    static void affine(const T* x_, float scale_, float offset_, T* out_, long size_) {
+        clamp_affine<T>(
+            x_, scale_, offset_,
+            -std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(),
+            out_, size_
+        );
+    }
+
+    template<class T>
+    static void clamp_affine(const T* x_, float scale_, float offset_, float lower_, float upper_, T* out_, long size_) {
+        if constexpr (std::is_same<T, float>::value) {
+            kernels::table().clamp_affine(x_, scale_, offset_, lower_, upper_, out_, size_);
+        } else {
+            for (long i = 0; i < size_; ++i) { out_[i] = T(min(max(x_[i] * scale_ + offset_, lower_), upper_)); }
+        }
+    }
+
+    template<class T>
+    static void weighted_sum(const T* const* inputs_, const float* weights_, int count_, T* out_, long size_) {
+        if constexpr (std::is_same<T, float>::value) {
+            kernels::table().weighted_sum(inputs_, weights_, count_, out_, size_);
+        } else {
+            for (long i = 0; i < size_; ++i) {
+                float sum_ = 0.0f;
+                for (int k = 0; k < count_; ++k) { sum_ += weights_[k] * inputs_[k][i]; }
+                out_[i] = T(sum_);
+            }
+        }
+    }
+
+    template<class T>
+    static void cfg_combine(const T* negative_, const T* positive_, float scale_, T* out_, long size_) {
+        if constexpr (std::is_same<T, float>::value) {
+            kernels::table().cfg_combine(negative_, positive_, scale_, out_, size_);
+        } else {
+            for (long i = 0; i < size_; ++i) { out_[i] = T(negative_[i] + scale_ * (positive_[i] - negative_[i])); }
+        }
+    }
+
+    template<class T>
+    static float reduce_sum(const T* x_, long size_) {
+        if constexpr (std::is_same<T, float>::value) {
+            return kernels::table().reduce_sum(x_, size_);
+        } else {
+            float sum_ = 0.0f;
+            for (long i = 0; i < size_; ++i) { sum_ += float(x_[i]); }
+            return sum_;
+        }
+    }
+
+    static void box_muller(const uint32_t* bits_, float* out_, long size_) {
+        kernels::table().box_muller(bits_, out_, size_);
+    }
+
+    static void pixels_to_planar(
+        const uint8_t* pixels_, int channels_, float scale_, float offset_, float* planar_, long plane_size_, long count_
+    ) {
+        kernels::table().pixels_to_planar(pixels_, channels_, scale_, offset_, planar_, plane_size_, count_);
+    }
+
+    static void planar_to_pixels(
+        const float* planar_, long plane_size_, float scale_, float offset_, uint8_t* pixels_, int channels_, long count_
+    ) {
+        kernels::table().planar_to_pixels(planar_, plane_size_, scale_, offset_, pixels_, channels_, count_);
+    }
+};
+
+} // namespace base
+} // namespace sd
+} // namespace onnx
+
+#endif  // ONNX_SD_CORE_KERNELS_ONCE
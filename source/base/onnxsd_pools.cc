@@ -0,0 +1,189 @@
+﻿/*
+ * Copyright (c) 2018-2050 SD_Pools - Arikan.Li
+ * Created by Arikan.Li on 2024/09/03.
+ */
+#ifndef ONNX_SD_CORE_POOLS_ONCE
+#define ONNX_SD_CORE_POOLS_ONCE
+
+#include "onnxsd_basic_refs.h"
+
+namespace onnx {
+namespace sd {
+namespace base {
+using namespace amon;
+
+#define TENSOR_POOL_ALIGNMENT       64                      // cache line, also header size
+#define TENSOR_POOL_MIN_OCTAVE      8                       // 256 B
+#define TENSOR_POOL_MAX_OCTAVE      30                      // 1 GiB, larger ones go straight to system
+#define TENSOR_POOL_OCTAVE_STEPS    4                       // sub-classes per power of 2, rounding waste under 25%
+#define TENSOR_POOL_MAX_CLASS       (TENSOR_POOL_MAX_OCTAVE * TENSOR_POOL_OCTAVE_STEPS)
+#define TENSOR_POOL_RETAIN_BYTES    (uint64_t(1) << 30)     // idle bytes kept for reuse
+
+typedef struct TensorPoolStatistics {
+    uint64_t pool_requests;
+    uint64_t pool_reuses;
+    uint64_t pool_used_bytes;           // handed out, not returned yet
+    uint64_t pool_retained_bytes;       // idle in free lists
+} TensorPoolStatistics;
+
+/**
+ * @details Size-class buffer pool, exposed to ORT as OrtAllocator. Each power of 2 split in 4 classes
+ *          (2^n x 1, 1.25, 1.5, 1.75), so block exceeds request by less than 25%. Tensors created
+ *          with it own their buffer: when Ort::Value destroyed, ORT calls Free and the block goes
+ *          back to its class free list, so repeated shapes reach steady state without system calls.
+ *          Idle blocks kept up to retain limit, above that returned to system. Thread safe.
+ */
+class TensorPool : public OrtAllocator {
+private:
+    typedef struct BlockHeader {
+        uint64_t block_class;
+        uint64_t block_bytes;
+    } BlockHeader;
+
+private:
+    std::mutex pool_lock;
+    std::vector<void*> pool_blocks[TENSOR_POOL_MAX_CLASS + 1];
+    Ort::MemoryInfo pool_info;
+    uint64_t pool_retain_limit;
+    uint64_t pool_requests = 0;
+    uint64_t pool_reuses = 0;
+    uint64_t pool_used_bytes = 0;
+    uint64_t pool_retained_bytes = 0;
+
+private:
+    static uint64_t class_bytes(uint64_t class_) {
+        uint64_t octave_ = class_ / TENSOR_POOL_OCTAVE_STEPS;
+        uint64_t step_ = class_ % TENSOR_POOL_OCTAVE_STEPS;
+        return (uint64_t(1) << octave_) / TENSOR_POOL_OCTAVE_STEPS * (TENSOR_POOL_OCTAVE_STEPS + step_);
+    }
+
+    static uint64_t size_class(size_t bytes_) {
+        uint64_t octave_ = TENSOR_POOL_MIN_OCTAVE;
+        while (octave_ <= TENSOR_POOL_MAX_OCTAVE && (uint64_t(1) << (octave_ + 1)) < bytes_) { ++octave_; }
+        uint64_t class_ = octave_ * TENSOR_POOL_OCTAVE_STEPS;
+        while (class_ <= TENSOR_POOL_MAX_CLASS && class_bytes(class_) < bytes_) { ++class_; }
+        return class_;
+    }
+
+    static BlockHeader* header_of(void* data_) {
+        return (BlockHeader*) ((uint8_t*) data_ - TENSOR_POOL_ALIGNMENT);
+    }
+
+    static void* system_alloc(uint64_t class_, size_t bytes_);
+    static void system_free(void* data_);
+
+    static void* ORT_API_CALL pool_alloc(OrtAllocator* this_, size_t size_);
+    static void ORT_API_CALL pool_free(OrtAllocator* this_, void* data_);
+    static const OrtMemoryInfo* ORT_API_CALL pool_memory_info(const OrtAllocator* this_);
+
+public:
+    explicit TensorPool(uint64_t retain_limit_bytes_ = TENSOR_POOL_RETAIN_BYTES);
+    ~TensorPool();
+
+    static TensorPool& instance();
+
+    void* acquire(size_t bytes_);
+    void release(void* data_);
+    void trim();
+    TensorPoolStatistics statistics();
+};
+
+TensorPool::TensorPool(uint64_t retain_limit_bytes_) :
+    OrtAllocator{},
+    pool_info(Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeDefault)),
+    pool_retain_limit(retain_limit_bytes_) {
+    // optional members (Reserve, stats...) left null, ORT checks them before use
+    OrtAllocator::version = ORT_API_VERSION;
+    OrtAllocator::Alloc = &TensorPool::pool_alloc;
+    OrtAllocator::Free = &TensorPool::pool_free;
+    OrtAllocator::Info = &TensorPool::pool_memory_info;
+}
+
+TensorPool::~TensorPool() {
+    trim();
+}
+
+TensorPool& TensorPool::instance() {
+    // never destroyed, tensors released during static destruction still have somewhere to go
+    static auto* pool_ = new TensorPool();
+    return *pool_;
+}
+
+void* TensorPool::system_alloc(uint64_t class_, size_t bytes_) {
+    void* block_ = ::operator new(TENSOR_POOL_ALIGNMENT + bytes_, std::align_val_t(TENSOR_POOL_ALIGNMENT));
+    auto* header_ = (BlockHeader*) block_;
+    header_->block_class = class_;
+    header_->block_bytes = uint64_t(bytes_);
+    return (uint8_t*) block_ + TENSOR_POOL_ALIGNMENT;
+}
+
+void TensorPool::system_free(void* data_) {
+    ::operator delete(header_of(data_), std::align_val_t(TENSOR_POOL_ALIGNMENT));
+}
+
+void* ORT_API_CALL TensorPool::pool_alloc(OrtAllocator* this_, size_t size_) {
+    return static_cast<TensorPool*>(this_)->acquire(size_);
+}
+
+void ORT_API_CALL TensorPool::pool_free(OrtAllocator* this_, void* data_) {
+    static_cast<TensorPool*>(this_)->release(data_);
+}
+
+const OrtMemoryInfo* ORT_API_CALL TensorPool::pool_memory_info(const OrtAllocator* this_) {
+    return static_cast<const TensorPool*>(this_)->pool_info;
+}
+
+void* TensorPool::acquire(size_t bytes_) {
+    uint64_t class_ = size_class(max(bytes_, size_t(1)));
+    size_t block_bytes_ = (class_ <= TENSOR_POOL_MAX_CLASS) ? size_t(class_bytes(class_)) : bytes_;
+    {
+        std::lock_guard<std::mutex> lock(pool_lock);
+        pool_requests++;
+        pool_used_bytes += block_bytes_;
+        if (class_ <= TENSOR_POOL_MAX_CLASS && !pool_blocks[class_].empty()) {
+            void* data_ = pool_blocks[class_].back();
+            pool_blocks[class_].pop_back();
+            pool_retained_bytes -= block_bytes_;
+            pool_reuses++;
+            return data_;
+        }
+    }
+    return system_alloc(class_, block_bytes_);
+}
+
+void TensorPool::release(void* data_) {
+    if (data_ == nullptr) { return; }
+    BlockHeader* header_ = header_of(data_);
+    uint64_t class_ = header_->block_class;
+    uint64_t block_bytes_ = header_->block_bytes;
+    {
+        std::lock_guard<std::mutex> lock(pool_lock);
+        pool_used_bytes -= block_bytes_;
+        if (class_ <= TENSOR_POOL_MAX_CLASS && pool_retained_bytes + block_bytes_ <= pool_retain_limit) {
+            pool_blocks[class_].push_back(data_);
+            pool_retained_bytes += block_bytes_;
+            return;
+        }
+    }
+    system_free(data_);
+}
+
+void TensorPool::trim() {
+    std::lock_guard<std::mutex> lock(pool_lock);
+    for (auto &blocks_ : pool_blocks) {
+        for (void* data_ : blocks_) { system_free(data_); }
+        blocks_.clear();
+    }
+    pool_retained_bytes = 0;
+}
+
+TensorPoolStatistics TensorPool::statistics() {
+    std::lock_guard<std::mutex> lock(pool_lock);
+    return TensorPoolStatistics{pool_requests, pool_reuses, pool_used_bytes, pool_retained_bytes};
+}
+
+} // namespace base
+} // namespace sd
+} // namespace onnx
+
+#endif  // ONNX_SD_CORE_POOLS_ONCE
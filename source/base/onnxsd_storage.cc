@@ -0,0 +1,390 @@
+﻿/*
+ * Copyright (c) 2018-2050 SD_Storage - Arikan.Li
+ * Created by Arikan.Li on 2024/08/28.
+ */
+#ifndef ONNX_SD_CORE_STORAGE_ONCE
+#define ONNX_SD_CORE_STORAGE_ONCE
+
+#include "onnxsd_basic_refs.h"
+#include "onnxsd_basic_tools.cc"
+
+namespace onnx {
+namespace sd {
+namespace base {
+
+#define EMBEDDING_STORE_MAGIC       0x4544534FU     // 'OSDE'
+#define EMBEDDING_STORE_VERSION     2U          // 2: SHA-256 names, 1 was FNV-1a pairs
+#define EMBEDDING_STORE_MAX_RANK    4
+#define EMBEDDING_STORE_CHUNK_SIZE  (1024 * 1024)
+
+/**
+ * @details SHA-256 (FIPS 180-4), streamed, the store keeps leading 128 bits as content address.
+ */
+class StoreDigest {
+private:
+    uint32_t digest_state[8] = {
+        0x6A09E667U, 0xBB67AE85U, 0x3C6EF372U, 0xA54FF53AU, 0x510E527FU, 0x9B05688CU, 0x1F83D9ABU, 0x5BE0CD19U,
+    };
+    uint8_t digest_block[64] = {};
+    size_t digest_filled = 0;
+    uint64_t digest_length = 0;
+
+private:
+    static uint32_t rotate(uint32_t x_, int n_) { return (x_ >> n_) | (x_ << (32 - n_)); }
+
+    void compress(const uint8_t* block_) {
+        static const uint32_t round_keys_[64] = {
+            0x428A2F98U, 0x71374491U, 0xB5C0FBCFU, 0xE9B5DBA5U, 0x3956C25BU, 0x59F111F1U, 0x923F82A4U, 0xAB1C5ED5U,
+            0xD807AA98U, 0x12835B01U, 0x243185BEU, 0x550C7DC3U, 0x72BE5D74U, 0x80DEB1FEU, 0x9BDC06A7U, 0xC19BF174U,
+            0xE49B69C1U, 0xEFBE4786U, 0x0FC19DC6U, 0x240CA1CCU, 0x2DE92C6FU, 0x4A7484AAU, 0x5CB0A9DCU, 0x76F988DAU,
+            0x983E5152U, 0xA831C66DU, 0xB00327C8U, 0xBF597FC7U, 0xC6E00BF3U, 0xD5A79147U, 0x06CA6351U, 0x14292967U,
+            0x27B70A85U, 0x2E1B2138U, 0x4D2C6DFCU, 0x53380D13U, 0x650A7354U, 0x766A0ABBU, 0x81C2C92EU, 0x92722C85U,
+            0xA2BFE8A1U, 0xA81A664BU, 0xC24B8B70U, 0xC76C51A3U, 0xD192E819U, 0xD6990624U, 0xF40E3585U, 0x106AA070U,
+            0x19A4C116U, 0x1E376C08U, 0x2748774CU, 0x34B0BCB5U, 0x391C0CB3U, 0x4ED8AA4AU, 0x5B9CCA4FU, 0x682E6FF3U,
+            0x748F82EEU, 0x78A5636FU, 0x84C87814U, 0x8CC70208U, 0x90BEFFFAU, 0xA4506CEBU, 0xBEF9A3F7U, 0xC67178F2U,
+        };
+        uint32_t w_[64];
+        for (int i = 0; i < 16; ++i) {
+            w_[i] = (uint32_t(block_[i * 4]) << 24) | (uint32_t(block_[i * 4 + 1]) << 16) |
+                    (uint32_t(block_[i * 4 + 2]) << 8) | uint32_t(block_[i * 4 + 3]);
+        }
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0_ = rotate(w_[i - 15], 7) ^ rotate(w_[i - 15], 18) ^ (w_[i - 15] >> 3);
+            uint32_t s1_ = rotate(w_[i - 2], 17) ^ rotate(w_[i - 2], 19) ^ (w_[i - 2] >> 10);
+            w_[i] = w_[i - 16] + s0_ + w_[i - 7] + s1_;
+        }
+        uint32_t s_[8];
+        std::copy(digest_state, digest_state + 8, s_);
+        for (int i = 0; i < 64; ++i) {
+            uint32_t t1_ = s_[7] + (rotate(s_[4], 6) ^ rotate(s_[4], 11) ^ rotate(s_[4], 25)) +
+                           ((s_[4] & s_[5]) ^ (~s_[4] & s_[6])) + round_keys_[i] + w_[i];
+            uint32_t t2_ = (rotate(s_[0], 2) ^ rotate(s_[0], 13) ^ rotate(s_[0], 22)) +
+                           ((s_[0] & s_[1]) ^ (s_[0] & s_[2]) ^ (s_[1] & s_[2]));
+            std::copy_backward(s_, s_ + 7, s_ + 8);
+            s_[4] += t1_;
+            s_[0] = t1_ + t2_;
+        }
+        for (int i = 0; i < 8; ++i) { digest_state[i] += s_[i]; }
+    }
+
+public:
+    void update(const void* data_, size_t size_) {
+        const auto* bytes_ = (const uint8_t*) data_;
+        digest_length += size_;
+        while (size_ > 0) {
+            size_t take_ = min(size_, sizeof(digest_block) - digest_filled);
+            memcpy(digest_block + digest_filled, bytes_, take_);
+            digest_filled += take_;
+            bytes_ += take_;
+            size_ -= take_;
+            if (digest_filled == sizeof(digest_block)) {
+                compress(digest_block);
+                digest_filled = 0;
+            }
+        }
+    }
+
+    void finish(uint64_t (&digest_)[2]) {
+        uint64_t bits_ = digest_length * 8;
+        uint8_t padding_[72] = {0x80};
+        size_t padding_size_ = ((digest_filled < 56) ? 56 : 120) - digest_filled;
+        for (int i = 0; i < 8; ++i) { padding_[padding_size_ + i] = uint8_t(bits_ >> (56 - 8 * i)); }
+        update(padding_, padding_size_ + 8);
+        digest_[0] = (uint64_t(digest_state[0]) << 32) | digest_state[1];
+        digest_[1] = (uint64_t(digest_state[2]) << 32) | digest_state[3];
+    }
+};
+
+/**
+ * @details Content-addressed on-disk store for prompt embeddings, one file per prompt under store root.
+ *          File name is SHA-256 (leading 128 bits) of (model fingerprint, tokenizer config, prompt),
+ *          fingerprint being the same digest of whole model file (cached in sidecar by path, size & mtime),
+ *          so worker processes sharing the same root share entries. Files written to temp then renamed,
+ *          readers memory-map them read-only, copy value out & unmap right away, so open mappings never
+ *          pile up with catalogue size (callers keep hits in EmbeddingCache prompt level).
+ */
+class EmbeddingStore {
+private:
+    typedef struct StoreHeader {
+        uint32_t store_magic;
+        uint32_t store_version;
+        uint64_t store_digest[2];
+        uint64_t store_rank;
+        int64_t store_shape[EMBEDDING_STORE_MAX_RANK];
+        uint64_t store_count;
+    } StoreHeader;
+
+    typedef struct StoreMapping {
+        const uint8_t* mapping_view;
+        size_t mapping_size;
+#ifdef _WIN32
+        HANDLE mapping_handle;
+#endif
+    } StoreMapping;
+
+private:
+    std::string store_root;
+    std::string store_salt;
+
+private:
+    static void make_digest(const std::string &material_, uint64_t (&digest_)[2]);
+    void prompt_digest(const std::string &prompts_, uint64_t (&digest_)[2]) const;
+    static std::string make_name(const uint64_t (&digest_)[2]);
+    static std::string make_root(std::string store_root_);
+    static bool file_identity(const std::string &file_path_, uint64_t &file_size_, int64_t &file_mtime_);
+    static bool file_digest(const std::string &file_path_, uint64_t (&digest_)[2]);
+    std::string make_path(const uint64_t (&digest_)[2]) const;
+    bool open_mapping(const std::string &path_, StoreMapping &mapping_) const;
+    static void close_mapping(StoreMapping &mapping_);
+
+public:
+    explicit EmbeddingStore(std::string store_root_, std::string store_salt_);
+    ~EmbeddingStore();
+
+    bool available() const { return !store_root.empty(); }
+    bool fetch(const std::string &prompts_, Tensor &output_);
+    bool store(const std::string &prompts_, const Tensor &value_);
+
+    static std::string fingerprint(const std::string &file_path_, const std::string &store_root_);
+};
+
+EmbeddingStore::EmbeddingStore(std::string store_root_, std::string store_salt_) :
+    store_root(std::move(store_root_)), store_salt(std::move(store_salt_)) {
+    store_root = make_root(store_root);
+}
+
+std::string EmbeddingStore::make_root(std::string store_root_) {
+    if (store_root_.empty()) { return store_root_; }
+    if (store_root_.back() == '/' || store_root_.back() == '\\') { store_root_.pop_back(); }
+#ifdef _WIN32
+    CreateDirectoryA(store_root_.c_str(), nullptr);
+#else
+    mkdir(store_root_.c_str(), 0755);
+#endif
+    return store_root_;
+}
+
+EmbeddingStore::~EmbeddingStore() = default;
+
+bool EmbeddingStore::file_identity(const std::string &file_path_, uint64_t &file_size_, int64_t &file_mtime_) {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA file_data_;
+    if (!GetFileAttributesExA(file_path_.c_str(), GetFileExInfoStandard, &file_data_)) { return false; }
+    file_size_ = (uint64_t(file_data_.nFileSizeHigh) << 32) | uint64_t(file_data_.nFileSizeLow);
+    file_mtime_ = int64_t((uint64_t(file_data_.ftLastWriteTime.dwHighDateTime) << 32) |
+                          uint64_t(file_data_.ftLastWriteTime.dwLowDateTime));     // 100 ns ticks
+#else
+    struct stat file_stat_{};
+    if (stat(file_path_.c_str(), &file_stat_) != 0) { return false; }
+    file_size_ = uint64_t(file_stat_.st_size);
+#if defined(__APPLE__)
+    file_mtime_ = int64_t(file_stat_.st_mtimespec.tv_sec) * 1000000000LL + int64_t(file_stat_.st_mtimespec.tv_nsec);
+#else
+    file_mtime_ = int64_t(file_stat_.st_mtim.tv_sec) * 1000000000LL + int64_t(file_stat_.st_mtim.tv_nsec);
+#endif
+#endif
+    return true;
+}
+
+bool EmbeddingStore::file_digest(const std::string &file_path_, uint64_t (&digest_)[2]) {
+    std::ifstream file_(file_path_, std::ios::binary);
+    if (!file_.is_open()) { return false; }
+    StoreDigest hasher_;
+    std::vector<char> chunk_(EMBEDDING_STORE_CHUNK_SIZE);
+    while (file_) {
+        file_.read(chunk_.data(), std::streamsize(chunk_.size()));
+        hasher_.update(chunk_.data(), size_t(file_.gcount()));
+    }
+    hasher_.finish(digest_);
+    return file_.eof();
+}
+
+std::string EmbeddingStore::fingerprint(const std::string &file_path_, const std::string &store_root_) {
+    // whole file hashed, digest kept in sidecar under store root keyed by (path, size, mtime),
+    // so only first start after model replaced pays for reading it
+    uint64_t file_size_ = 0;
+    int64_t file_mtime_ = 0;
+    if (!file_identity(file_path_, file_size_, file_mtime_)) { return file_path_; }
+    std::string identity_ = file_path_ + "|" + std::to_string(file_size_) + "|" + std::to_string(file_mtime_);
+
+    std::string sidecar_path_;
+    if (!store_root_.empty()) {
+        uint64_t sidecar_digest_[2];
+        make_digest(file_path_, sidecar_digest_);
+        // salt (so fingerprints) made before store constructed, root may not exist yet
+        sidecar_path_ = make_root(store_root_) + "/" + make_name(sidecar_digest_) + ".fp";
+
+        std::ifstream sidecar_(sidecar_path_);
+        std::string cached_identity_, cached_digest_;
+        if (std::getline(sidecar_, cached_identity_) && std::getline(sidecar_, cached_digest_) &&
+            cached_identity_ == identity_ && cached_digest_.size() == 32) {
+            return std::to_string(file_size_) + ":" + cached_digest_;
+        }
+    }
+
+    uint64_t file_digest_[2];
+    if (!file_digest(file_path_, file_digest_)) { return file_path_; }
+    std::string digest_name_ = make_name(file_digest_);
+
+    if (!sidecar_path_.empty()) {
+        // same write-aside & rename as entries, racing processes write identical content
+        std::string temp_path_ = sidecar_path_ + "." + std::to_string(std::random_device{}()) + ".tmp";
+        bool written_;
+        {
+            std::ofstream sidecar_(temp_path_, std::ios::trunc);
+            sidecar_ << identity_ << '\n' << digest_name_ << '\n';
+            written_ = sidecar_.good();
+        }
+#ifdef _WIN32
+        bool renamed_ = written_ && MoveFileExA(temp_path_.c_str(), sidecar_path_.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        bool renamed_ = written_ && std::rename(temp_path_.c_str(), sidecar_path_.c_str()) == 0;
+#endif
+        if (!renamed_) { std::remove(temp_path_.c_str()); }
+    }
+    return std::to_string(file_size_) + ":" + digest_name_;
+}
+
+void EmbeddingStore::make_digest(const std::string &material_, uint64_t (&digest_)[2]) {
+    StoreDigest hasher_;
+    hasher_.update(material_.data(), material_.size());
+    hasher_.finish(digest_);
+}
+
+void EmbeddingStore::prompt_digest(const std::string &prompts_, uint64_t (&digest_)[2]) const {
+    std::string material_ = store_salt;
+    material_.push_back('\0');
+    material_.append(prompts_);
+    make_digest(material_, digest_);
+}
+
+std::string EmbeddingStore::make_name(const uint64_t (&digest_)[2]) {
+    char name_[40];
+    snprintf(name_, sizeof(name_), "%016llx%016llx",
+             (unsigned long long) digest_[0], (unsigned long long) digest_[1]);
+    return name_;
+}
+
+std::string EmbeddingStore::make_path(const uint64_t (&digest_)[2]) const {
+    return store_root + "/" + make_name(digest_) + ".emb";
+}
+
+bool EmbeddingStore::open_mapping(const std::string &path_, StoreMapping &mapping_) const {
+#ifdef _WIN32
+    HANDLE file_ = CreateFileA(
+        path_.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+    );
+    if (file_ == INVALID_HANDLE_VALUE) { return false; }
+    LARGE_INTEGER file_size_;
+    if (!GetFileSizeEx(file_, &file_size_) || file_size_.QuadPart < LONGLONG(sizeof(StoreHeader))) {
+        CloseHandle(file_);
+        return false;
+    }
+    HANDLE handle_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file_);
+    if (handle_ == nullptr) { return false; }
+    void* view_ = MapViewOfFile(handle_, FILE_MAP_READ, 0, 0, 0);
+    if (view_ == nullptr) {
+        CloseHandle(handle_);
+        return false;
+    }
+    mapping_ = {(const uint8_t*) view_, size_t(file_size_.QuadPart), handle_};
+#else
+    int fd_ = open(path_.c_str(), O_RDONLY);
+    if (fd_ < 0) { return false; }
+    struct stat file_stat_{};
+    if (fstat(fd_, &file_stat_) != 0 || file_stat_.st_size < off_t(sizeof(StoreHeader))) {
+        close(fd_);
+        return false;
+    }
+    void* view_ = mmap(nullptr, size_t(file_stat_.st_size), PROT_READ, MAP_SHARED, fd_, 0);
+    close(fd_);
+    if (view_ == MAP_FAILED) { return false; }
+    mapping_ = {(const uint8_t*) view_, size_t(file_stat_.st_size)};
+#endif
+    return true;
+}
+
+void EmbeddingStore::close_mapping(StoreMapping &mapping_) {
+    if (mapping_.mapping_view == nullptr) { return; }
+#ifdef _WIN32
+    UnmapViewOfFile(mapping_.mapping_view);
+    CloseHandle(mapping_.mapping_handle);
+#else
+    munmap((void*) mapping_.mapping_view, mapping_.mapping_size);
+#endif
+    mapping_.mapping_view = nullptr;
+}
+
+bool EmbeddingStore::fetch(const std::string &prompts_, Tensor &output_) {
+    if (!available()) { return false; }
+    uint64_t digest_[2];
+    prompt_digest(prompts_, digest_);
+    std::string path_ = make_path(digest_);
+
+    StoreMapping mapping_{};
+    if (!open_mapping(path_, mapping_)) { return false; }
+
+    // reject foreign / truncated / colliding files
+    const auto* header_ = (const StoreHeader*) mapping_.mapping_view;
+    bool valid_ = (
+        header_->store_magic == EMBEDDING_STORE_MAGIC &&
+        header_->store_version == EMBEDDING_STORE_VERSION &&
+        header_->store_digest[0] == digest_[0] && header_->store_digest[1] == digest_[1] &&
+        header_->store_rank > 0 && header_->store_rank <= EMBEDDING_STORE_MAX_RANK &&
+        mapping_.mapping_size == sizeof(StoreHeader) + header_->store_count * sizeof(float)
+    );
+    if (valid_) {
+        // copy out, mapping only lives for this call
+        TensorShape value_shape_(header_->store_shape, header_->store_shape + header_->store_rank);
+        output_ = TensorHelper::allocate<float>(value_shape_);
+        const auto* value_data_ = (const float*) (mapping_.mapping_view + sizeof(StoreHeader));
+        std::copy(value_data_, value_data_ + header_->store_count, output_.GetTensorMutableData<float>());
+    }
+    close_mapping(mapping_);
+    return valid_;
+}
+
+bool EmbeddingStore::store(const std::string &prompts_, const Tensor &value_) {
+    if (!available()) { return false; }
+    auto value_info_ = value_.GetTensorTypeAndShapeInfo();
+    TensorShape value_shape_ = value_info_.GetShape();
+    if (value_shape_.empty() || value_shape_.size() > EMBEDDING_STORE_MAX_RANK) { return false; }
+
+    StoreHeader header_{};
+    header_.store_magic = EMBEDDING_STORE_MAGIC;
+    header_.store_version = EMBEDDING_STORE_VERSION;
+    prompt_digest(prompts_, header_.store_digest);
+    header_.store_rank = uint64_t(value_shape_.size());
+    std::copy(value_shape_.begin(), value_shape_.end(), header_.store_shape);
+    header_.store_count = uint64_t(value_info_.GetElementCount());
+
+    // write aside then rename, concurrent readers only ever see complete files
+    std::string path_ = make_path(header_.store_digest);
+    std::string temp_path_ = path_ + "." + std::to_string(std::random_device{}()) + ".tmp";
+    {
+        std::ofstream file_(temp_path_, std::ios::binary | std::ios::trunc);
+        if (!file_.is_open()) { return false; }
+        file_.write((const char*) &header_, sizeof(StoreHeader));
+        file_.write((const char*) value_.GetTensorData<float>(), std::streamsize(header_.store_count * sizeof(float)));
+        if (!file_.good()) {
+            file_.close();
+            std::remove(temp_path_.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    bool renamed_ = MoveFileExA(temp_path_.c_str(), path_.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool renamed_ = std::rename(temp_path_.c_str(), path_.c_str()) == 0;
+#endif
+    if (!renamed_) { std::remove(temp_path_.c_str()); }
+    return renamed_;
+}
+
+} // namespace base
+} // namespace sd
+} // namespace onnx
+
+#endif  // ONNX_SD_CORE_STORAGE_ONCE
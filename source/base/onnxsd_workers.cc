@@ -0,0 +1,156 @@
+﻿/*
+ * Copyright (c) 2018-2050 SD_Workers - Arikan.Li
+ * Created by Arikan.Li on 2024/08/20.
+ */
+#ifndef ONNX_SD_CORE_WORKERS_ONCE
+#define ONNX_SD_CORE_WORKERS_ONCE
+
+#include "onnxsd_basic_refs.h"
+
+namespace onnx {
+namespace sd {
+namespace base {
+
+typedef std::function<void()> WorkerTask;
+
+/**
+ * @details Simple FIFO worker pool, tasks submitted are executed by internal threads in order
+ *          of submission. When pool stopped, no more task accepted, queued ones drained before join.
+ */
+class WorkerPool {
+private:
+    std::vector<std::thread> worker_threads;
+    std::deque<WorkerTask> worker_tasks;
+    std::mutex worker_lock;
+    std::condition_variable worker_signal;
+    bool worker_stopped = false;
+
+private:
+    void working_loop();
+
+public:
+    explicit WorkerPool(size_t worker_count_ = 1);
+    ~WorkerPool();
+
+    bool submit(WorkerTask task_);
+    size_t pending();
+    void stop();
+};
+
+WorkerPool::WorkerPool(size_t worker_count_) {
+    worker_count_ = max(worker_count_, size_t(1));
+    for (size_t i = 0; i < worker_count_; ++i) {
+        worker_threads.emplace_back(&WorkerPool::working_loop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    stop();
+}
+
+void WorkerPool::working_loop() {
+    while (true) {
+        WorkerTask task_;
+        {
+            std::unique_lock<std::mutex> lock(worker_lock);
+            worker_signal.wait(lock, [this] { return worker_stopped || !worker_tasks.empty(); });
+            if (worker_stopped && worker_tasks.empty()) { return; }
+            task_ = std::move(worker_tasks.front());
+            worker_tasks.pop_front();
+        }
+        task_();
+    }
+}
+
+bool WorkerPool::submit(WorkerTask task_) {
+    {
+        std::lock_guard<std::mutex> lock(worker_lock);
+        if (worker_stopped) { return false; }
+        worker_tasks.push_back(std::move(task_));
+    }
+    worker_signal.notify_one();
+    return true;
+}
+
+size_t WorkerPool::pending() {
+    std::lock_guard<std::mutex> lock(worker_lock);
+    return worker_tasks.size();
+}
+
+void WorkerPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(worker_lock);
+        if (worker_stopped) { return; }
+        worker_stopped = true;
+    }
+    worker_signal.notify_all();
+    for (auto &thread_ : worker_threads) {
+        if (thread_.joinable()) { thread_.join(); }
+    }
+    worker_threads.clear();
+}
+
+/**
+ * @details Bounded blocking FIFO, used to hand over jobs between pipeline stages. Producer blocks
+ *          when full (back-pressure), consumer blocks when empty. After close, push refused and
+ *          pop keeps draining remain items, then report false.
+ */
+template<class T>
+class WorkerQueue {
+private:
+    std::deque<T> queue_items;
+    std::mutex queue_lock;
+    std::condition_variable queue_signal_push;
+    std::condition_variable queue_signal_pop;
+    size_t queue_capacity = 1;
+    bool queue_closed = false;
+
+public:
+    explicit WorkerQueue(size_t queue_capacity_ = 1) : queue_capacity(max(queue_capacity_, size_t(1))) {};
+    ~WorkerQueue() = default;
+
+    bool push(T item_);
+    bool pop(T &item_);
+    void close();
+};
+
+template<class T>
+bool WorkerQueue<T>::push(T item_) {
+    {
+        std::unique_lock<std::mutex> lock(queue_lock);
+        queue_signal_push.wait(lock, [this] { return queue_closed || queue_items.size() < queue_capacity; });
+        if (queue_closed) { return false; }
+        queue_items.push_back(std::move(item_));
+    }
+    queue_signal_pop.notify_one();
+    return true;
+}
+
+template<class T>
+bool WorkerQueue<T>::pop(T &item_) {
+    {
+        std::unique_lock<std::mutex> lock(queue_lock);
+        queue_signal_pop.wait(lock, [this] { return queue_closed || !queue_items.empty(); });
+        if (queue_items.empty()) { return false; }
+        item_ = std::move(queue_items.front());
+        queue_items.pop_front();
+    }
+    queue_signal_push.notify_one();
+    return true;
+}
+
+template<class T>
+void WorkerQueue<T>::close() {
+    {
+        std::lock_guard<std::mutex> lock(queue_lock);
+        queue_closed = true;
+    }
+    queue_signal_push.notify_all();
+    queue_signal_pop.notify_all();
+}
+
+} // namespace base
+} // namespace sd
+} // namespace onnx
+
+#endif  // ONNX_SD_CORE_WORKERS_ONCE
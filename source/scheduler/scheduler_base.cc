@@ -16,39 +16,93 @@ using namespace amon;
 
 class SchedulerBase {
 private:
-    RandomGenerator random_generator;
+    NoiseGenerator noise_generator;
+    vector<NoiseGenerator> noise_items;     // per batch item, set by seeded mask
+    long noise_item_size = 0;
+    std::unique_ptr<WorkerPool> noise_worker;   // helper thread, created at first prefetch
+    std::future<void> noise_pending;
+    long noise_pending_step = -1;
+    vector<float> noise_ahead;              // filled by helper, swapped with scheduler_noise when used
 
 protected:
     typedef std::tuple<float, float, float> Predictants;
 
+    // per-element update: next = sample_coeff * sample + predict_coeff * predict + noise_coeff * noise
+    typedef struct StepCoefficients {
+        float sample_coeff;
+        float predict_coeff;
+        float noise_coeff;
+    } StepCoefficients;
+
 protected:
     SchedulerConfig scheduler_config = DEFAULT_SCHEDULER_CONFIG;
     std::map<long, int64_t> scheduler_timesteps;
     vector<float> scheduler_sigmas;
     vector<float> alphas_cumprod;
     float scheduler_max_sigma;
+    vector<float> scheduler_predict;        // step scratch, sized once per latent size
+    vector<float> scheduler_guided;         // guided prediction, only for schedulers with history
+    vector<float> scheduler_noise;          // per step noise, only when noise_coeff != 0
 
 protected:
     Predictants find_predict_params_at(float sigma_) ;
     long find_closest_timestep_index(long time_);
     float generate_sigma_at(float timestep_);
+    float generate_timestep_at(float sigma_);
+    bool generate_spacing(uint64_t inference_steps_, vector<float> &timesteps_, vector<float> &sigmas_);
+    const float* step_noise(long data_size_, long step_index_);
+    void wait_prefetch();
 
 protected:
     virtual uint64_t correction_steps(uint64_t inference_steps_) { return inference_steps_; };
-    virtual std::vector<float> execute_method(
-        const float *predict_data_, const float* samples_data_,
-        long data_size_, long step_index_, float random_intensity_) = 0;
+    /**
+     * @details Schedulers whose update is a per-element formula only give coefficients (and noise),
+     *          so CFG, prediction & update can be fused into one pass. Return false if not.
+     */
+    virtual bool step_coefficients(long step_index_, float random_intensity_, StepCoefficients &coeffs_) {
+        return false;
+    };
+    /**
+     * @details Gaussian noise of step, deterministic function of (seed, step): each batch item
+     *          keyed by its own seed (when mask made with seeds), stream step + 1.
+     */
+    virtual void generate_noise(float* noise_data_, long data_size_, long step_index_);
+    /**
+     * @details Whether step consumes noise (so prefetch worth it), schedulers overriding
+     *          execute_method with stochastic update should tell here.
+     */
+    virtual bool require_noise(long step_index_, float random_intensity_) {
+        StepCoefficients coeffs_{};
+        return step_coefficients(step_index_, random_intensity_, coeffs_) && coeffs_.noise_coeff != 0.0f;
+    };
+    /**
+     * @details Write next sample into output_data_ (never aliasing samples_data_), called every step,
+     *          so implementations should not allocate once warmed up. Default uses step_coefficients,
+     *          schedulers keeping history (Heun, LMS, UniPC...) override it.
+     */
+    virtual void execute_method(
+        const float *predict_data_, const float* samples_data_, float* output_data_,
+        long data_size_, long step_index_, float random_intensity_);
 
 public:
     explicit SchedulerBase(const SchedulerConfig &scheduler_config_ = DEFAULT_SCHEDULER_CONFIG);
     virtual ~SchedulerBase();
 
     void create();
-    uint64_t init(uint64_t inference_steps_) ;
+    uint64_t init(uint64_t inference_steps_, float denoise_strength_ = 1.0f) ;
     Tensor mask(const TensorShape& mask_shape_);
-    Tensor scale(const Tensor& masker_, int step_index_);
-    Tensor time(int step_index_);
-    Tensor step(const Tensor& sample_, const Tensor& dnoise_, int step_index_, float random_intensity_ = 1.0f);
+    Tensor mask(const TensorShape& mask_shape_, const std::vector<int64_t>& seeds_);
+    void prefetch(long data_size_, int step_index_, float random_intensity_ = 1.0f);
+    void scale(const float* latent_data_, float* output_data_, long data_size_, int step_index_);
+    int64_t time(int step_index_);
+    void step(
+        const float* sample_data_, const float* dnoise_data_, float* output_data_,
+        long data_size_, int step_index_, float random_intensity_ = 1.0f
+    );
+    void step(
+        const float* sample_data_, const float* negative_data_, const float* positive_data_, float guidance_scale_,
+        float* output_data_, long data_size_, int step_index_, float random_intensity_ = 1.0f
+    );
     void uninit();
     void release();
 };
@@ -56,15 +110,17 @@ public:
 SchedulerBase::SchedulerBase(const SchedulerConfig& scheduler_config_){
     this->scheduler_max_sigma = 0;
     this->scheduler_config = scheduler_config_;
-    this->random_generator.seed(scheduler_config_.scheduler_seed);
+    this->noise_generator.seed(scheduler_config_.scheduler_seed);
 }
 
 SchedulerBase::~SchedulerBase(){
+    wait_prefetch();
+    noise_worker.reset();
     scheduler_max_sigma = 0;
     alphas_cumprod.clear();
     scheduler_sigmas.clear();
     scheduler_timesteps.clear();
-    random_generator.~RandomGenerator();
+    noise_items.clear();
 }
 
 long SchedulerBase::find_closest_timestep_index(long time_) {
@@ -92,6 +148,118 @@ float SchedulerBase::generate_sigma_at(float timestep_) {
     return sigma;
 }
 
+float SchedulerBase::generate_timestep_at(float sigma_) {
+    // inverse of generate_sigma_at, interpolated in log sigma between neighbour training steps
+    long training_steps_ = long(alphas_cumprod.size());
+    auto sigma_of = [&](long t_) -> double {
+        return std::sqrt((1.0 - double(alphas_cumprod[t_])) / double(alphas_cumprod[t_]));
+    };
+    double log_sigma_ = std::log(max(double(sigma_), 1e-10));
+    if (log_sigma_ <= std::log(sigma_of(0))) { return 0.0f; }
+    if (log_sigma_ >= std::log(sigma_of(training_steps_ - 1))) { return float(training_steps_ - 1); }
+
+    long low_idx = 0, high_idx = training_steps_ - 1;
+    while (high_idx - low_idx > 1) {
+        long mid_idx = (low_idx + high_idx) / 2;
+        if (std::log(sigma_of(mid_idx)) <= log_sigma_) { low_idx = mid_idx; } else { high_idx = mid_idx; }
+    }
+    double l_log = std::log(sigma_of(low_idx));
+    double h_log = std::log(sigma_of(high_idx));
+    double w = (log_sigma_ - l_log) / (h_log - l_log);
+    return float(double(low_idx) + w);
+}
+
+bool SchedulerBase::generate_spacing(uint64_t inference_steps_, vector<float> &timesteps_, vector<float> &sigmas_) {
+    long training_steps_ = long(scheduler_config.scheduler_training_steps);
+    const vector<float> &table_ = scheduler_config.scheduler_spacing_table;
+
+    switch (scheduler_config.scheduler_spacing_type) {
+        case SIGMA_SPACING_LINEAR: {
+            int start_at = 0;
+            int end_when = int(training_steps_ - 1);
+            float step_gap = (inference_steps_ > 1) ?
+                             float(end_when - start_at) / float(inference_steps_ - 1) :
+                             float(end_when);
+            for (uint32_t i = 0; i < inference_steps_; ++i) {
+                float t = float(end_when) - step_gap * float(i);
+                timesteps_.push_back(t);
+                sigmas_.push_back(generate_sigma_at(t));
+            }
+            break;
+        }
+        case SIGMA_SPACING_TRAILING: {
+            // t = round(training_steps - i * training_steps / steps) - 1, starts at last training step
+            double step_gap = double(training_steps_) / double(inference_steps_);
+            for (uint32_t i = 0; i < inference_steps_; ++i) {
+                float t = float(max(std::round(double(training_steps_) - step_gap * double(i)) - 1.0, 0.0));
+                timesteps_.push_back(t);
+                sigmas_.push_back(generate_sigma_at(t));
+            }
+            break;
+        }
+        case SIGMA_SPACING_KARRAS: {
+            // sigma = (max^(1/rho) + ramp * (min^(1/rho) - max^(1/rho)))^rho, ramp in [0, 1], rho = 7
+            double rho_ = 7.0;
+            double min_inv_rho_ = std::pow(double(generate_sigma_at(0)), 1.0 / rho_);
+            double max_inv_rho_ = std::pow(double(generate_sigma_at(float(training_steps_ - 1))), 1.0 / rho_);
+            for (uint32_t i = 0; i < inference_steps_; ++i) {
+                double ramp_ = (inference_steps_ > 1) ? double(i) / double(inference_steps_ - 1) : 0.0;
+                auto sigma = float(std::pow(max_inv_rho_ + ramp_ * (min_inv_rho_ - max_inv_rho_), rho_));
+                timesteps_.push_back(std::round(generate_timestep_at(sigma)));
+                sigmas_.push_back(sigma);
+            }
+            break;
+        }
+        case SIGMA_SPACING_EXPONENTIAL: {
+            double log_min_ = std::log(double(generate_sigma_at(0)));
+            double log_max_ = std::log(double(generate_sigma_at(float(training_steps_ - 1))));
+            for (uint32_t i = 0; i < inference_steps_; ++i) {
+                double ramp_ = (inference_steps_ > 1) ? double(i) / double(inference_steps_ - 1) : 0.0;
+                auto sigma = float(std::exp(log_max_ + ramp_ * (log_min_ - log_max_)));
+                timesteps_.push_back(std::round(generate_timestep_at(sigma)));
+                sigmas_.push_back(sigma);
+            }
+            break;
+        }
+        case SIGMA_SPACING_SIGMA_TABLE: {
+            // trailing 0 optional, always appended by init
+            for (float sigma : table_) {
+                if (sigma <= 0) { break; }
+                timesteps_.push_back(std::round(generate_timestep_at(sigma)));
+                sigmas_.push_back(sigma);
+            }
+            break;
+        }
+        case SIGMA_SPACING_TIMESTEP_TABLE: {
+            for (float t : table_) {
+                if (t < 0 || t > float(training_steps_ - 1)) {
+                    amon_report(class_exception(EXC_LOG_ERR, "ERROR:: spacing table timestep out of training range!"));
+                    return false;
+                }
+                timesteps_.push_back(t);
+                sigmas_.push_back(generate_sigma_at(t));
+            }
+            break;
+        }
+        default: {
+            amon_report(class_exception(EXC_LOG_ERR, "ERROR:: Unknown sigma spacing type"));
+            return false;
+        }
+    }
+
+    if (sigmas_.empty()) {
+        amon_report(class_exception(EXC_LOG_ERR, "ERROR:: spacing table is empty!"));
+        return false;
+    }
+    for (size_t i = 1; i < sigmas_.size(); ++i) {
+        if (sigmas_[i] > sigmas_[i - 1]) {
+            amon_report(class_exception(EXC_LOG_ERR, "ERROR:: spacing table must be descending in sigma!"));
+            return false;
+        }
+    }
+    return true;
+}
+
 SchedulerBase::Predictants SchedulerBase::find_predict_params_at(float sigma_)
 {
     float c_skip, c_out;
@@ -190,58 +358,94 @@ void SchedulerBase::create() {
     }
 }
 
-uint64_t SchedulerBase::init(uint64_t inference_steps_) {
-    std::vector<float> result;
-    if (inference_steps_ == 0) {
+uint64_t SchedulerBase::init(uint64_t inference_steps_, float denoise_strength_) {
+    bool by_table_ = (
+        scheduler_config.scheduler_spacing_type == SIGMA_SPACING_SIGMA_TABLE ||
+        scheduler_config.scheduler_spacing_type == SIGMA_SPACING_TIMESTEP_TABLE
+    );
+    if (inference_steps_ == 0 && !by_table_) {
         amon_report(class_exception(EXC_LOG_ERR, "ERROR:: inference_steps_ setting with 0!"));
         return 0;
     }
 
-    // linearspace
-    int start_at = 0;
-    int end_when = int(scheduler_config.scheduler_training_steps - 1);
-    float step_gap = (inference_steps_ > 1) ?
-                     float(end_when - start_at) / float(inference_steps_ - 1) :
-                     float(end_when);
-
-    for (uint32_t i = 0; i < inference_steps_; ++i) {
-        float t = float(end_when) - step_gap * float(i);
-        float sigma = generate_sigma_at(t);
-        scheduler_timesteps.insert(make_pair(long(i), int64_t(t)));
-        scheduler_sigmas.push_back(sigma);
-        scheduler_max_sigma = max(scheduler_max_sigma, sigma);
+    vector<float> timesteps_;
+    vector<float> sigmas_;
+    if (!generate_spacing(inference_steps_, timesteps_, sigmas_)) {
+        return 0;
+    }
+
+    // partial denoise (img2img), skip first floor((1 - strength) * steps) steps but keep at least one,
+    // remaining steps re-indexed from 0 so history based schedulers start clean
+    if (denoise_strength_ < 1.0f) {
+        // epsilon keeps e.g. (1 - 0.3f) * 10 at 7, float strength is never exact
+        double skip_ratio_ = 1.0 - double(max(denoise_strength_, 0.0f));
+        auto skip_steps_ = size_t(std::floor(skip_ratio_ * double(sigmas_.size()) + 1e-4));
+        skip_steps_ = min(skip_steps_, sigmas_.size() - 1);
+        timesteps_.erase(timesteps_.begin(), timesteps_.begin() + long(skip_steps_));
+        sigmas_.erase(sigmas_.begin(), sigmas_.begin() + long(skip_steps_));
+    }
+
+    // step count follows spacing (table size for tables)
+    scheduler_max_sigma = 0;
+    for (uint32_t i = 0; i < sigmas_.size(); ++i) {
+        scheduler_timesteps.insert(make_pair(long(i), int64_t(timesteps_[i])));
+        scheduler_sigmas.push_back(sigmas_[i]);
+        scheduler_max_sigma = max(scheduler_max_sigma, sigmas_[i]);
     }
     scheduler_sigmas.push_back(0);
-    return correction_steps(inference_steps_);
+    return correction_steps(uint64_t(sigmas_.size()));
 }
 
 Tensor SchedulerBase::mask(const TensorShape& mask_shape_){
-    return TensorHelper::random<float>(mask_shape_, random_generator, scheduler_max_sigma);
+    wait_prefetch();
+    noise_items.clear();
+    noise_item_size = 0;
+    if (scheduler_config.scheduler_seed == -1) {
+        noise_generator.seed(-1);       // random seed draws a new key each run, step noise follows it
+    }
+    return TensorHelper::random<float>(mask_shape_, noise_generator, scheduler_max_sigma);
 }
 
-Tensor SchedulerBase::scale(const Tensor& latent_, int step_index_){
+Tensor SchedulerBase::mask(const TensorShape& mask_shape_, const std::vector<int64_t>& seeds_){
+    if (seeds_.empty()) { return mask(mask_shape_); }
+    // each batch item owns its seed, so item[n] match a single run with seeds_[n]
+    TensorShape item_shape_ = mask_shape_;
+    item_shape_[0] = 1;
+    wait_prefetch();
+    noise_items.clear();
+    noise_item_size = 1;
+    for (int64_t dim_ : item_shape_) { noise_item_size *= long(dim_); }
+    std::vector<Tensor> item_masks_;
+    for (int64_t seed_ : seeds_) {
+        noise_items.emplace_back(seed_);
+        item_masks_.emplace_back(TensorHelper::random<float>(item_shape_, noise_items.back(), scheduler_max_sigma));
+    }
+    return TensorHelper::merge<float>(item_masks_, 0);
+}
+
+void SchedulerBase::scale(const float* latent_data_, float* output_data_, long data_size_, int step_index_){
     // Get step index of timestep from TimeSteps
     if (step_index_ >= scheduler_timesteps.size()) {
         throw std::runtime_error("from time not found target TimeSteps.");
     }
     float sigma = scheduler_sigmas[step_index_];
-    sigma = std::sqrt(sigma * sigma + 1);
-    return TensorHelper::divide<float>(latent_, sigma);
+    float factor = 1.0f / std::sqrt(sigma * sigma + 1);
+    KernelHelper::affine<float>(latent_data_, factor, 0.0f, output_data_, data_size_);
 }
 
-Tensor SchedulerBase::time(int step_index_){
+int64_t SchedulerBase::time(int step_index_){
     // Get step index of timestep from TimeSteps
     if (step_index_ >= scheduler_timesteps.size()) {
         throw std::runtime_error("from time not found target TimeSteps.");
     }
-    vector<int64_t> timestep_value_{scheduler_timesteps[step_index_]};
-    TensorShape timestep_shape_{1};
-    return TensorHelper::create<int64_t>(timestep_shape_, timestep_value_);
+    return scheduler_timesteps[step_index_];
 }
 
-Tensor SchedulerBase::step(
-    const Tensor& sample_,
-    const Tensor& dnoise_,
+void SchedulerBase::step(
+    const float* sample_data_,
+    const float* dnoise_data_,
+    float* output_data_,
+    long data_size_,
     int step_index_,
     float random_intensity_
 ) {
@@ -249,36 +453,166 @@ Tensor SchedulerBase::step(
     if (step_index_ >= scheduler_timesteps.size()) {
         throw std::runtime_error("from time not found target TimeSteps.");
     }
-
-    TensorShape output_shape_ = sample_.GetTensorTypeAndShapeInfo().GetShape();
-    long data_size_ = TensorHelper::get_data_size(sample_);
-    auto* sample_data_ = sample_.GetTensorData<float>();
-    auto* dnoise_data_ = dnoise_.GetTensorData<float>();
-    std::vector<float> predict_data_(data_size_);
+    if (scheduler_predict.size() != size_t(data_size_)) {
+        scheduler_predict.resize(data_size_);
+    }
 
     // do common prediction de-noise
     float sigma = scheduler_sigmas[step_index_];
     auto [c_skip, c_out, c_unused] = find_predict_params_at(sigma);
-    for (int i = 0; i < data_size_; i++) {
-        // predict_sample = sample * c_skip + c_out * dnoise
-        predict_data_[i] = sample_data_[i] * c_skip + dnoise_data_[i] * c_out;
-    }
+    // predict_sample = sample * c_skip + c_out * dnoise
+    KernelHelper::axpby<float>(c_skip, sample_data_, c_out, dnoise_data_, scheduler_predict.data(), data_size_);
 
-    std::vector<float> latent_value_ = execute_method(
-        predict_data_.data(), sample_data_, data_size_, step_index_, random_intensity_
+    execute_method(
+        scheduler_predict.data(), sample_data_, output_data_, data_size_, step_index_, random_intensity_
     );
-    Tensor result_latent = TensorHelper::create(output_shape_, latent_value_);
+}
+
+void SchedulerBase::step(
+    const float* sample_data_,
+    const float* negative_data_,
+    const float* positive_data_,
+    float guidance_scale_,
+    float* output_data_,
+    long data_size_,
+    int step_index_,
+    float random_intensity_
+) {
+    // Check step index of timestep from TimeSteps
+    if (step_index_ >= scheduler_timesteps.size()) {
+        throw std::runtime_error("from time not found target TimeSteps.");
+    }
+
+    StepCoefficients coeffs_{};
+    if (!step_coefficients(step_index_, random_intensity_, coeffs_)) {
+        // multistep schedulers record predictions, so guided one materialised once then normal step
+        if (scheduler_guided.size() != size_t(data_size_)) {
+            scheduler_guided.resize(data_size_);
+        }
+        if (negative_data_ != nullptr) {
+            KernelHelper::cfg_combine<float>(
+                negative_data_, positive_data_, guidance_scale_, scheduler_guided.data(), data_size_
+            );
+        } else {
+            std::copy(positive_data_, positive_data_ + data_size_, scheduler_guided.data());
+        }
+        step(sample_data_, scheduler_guided.data(), output_data_, data_size_, step_index_, random_intensity_);
+        return;
+    }
 
-    return result_latent;
+    // fold guidance (neg + g * (pos - neg)), prediction (c_skip, c_out) & update coefficients,
+    // then read sample/negative/positive once & write next latent once
+    float sigma = scheduler_sigmas[step_index_];
+    auto [c_skip, c_out, c_unused] = find_predict_params_at(sigma);
+    float dnoise_coeff_ = coeffs_.predict_coeff * c_out;
+
+    const float* inputs_[4];
+    float weights_[4];
+    int count_ = 0;
+    inputs_[count_] = sample_data_;
+    weights_[count_++] = coeffs_.sample_coeff + coeffs_.predict_coeff * c_skip;
+    if (negative_data_ != nullptr) {
+        inputs_[count_] = negative_data_;
+        weights_[count_++] = dnoise_coeff_ * (1.0f - guidance_scale_);
+        inputs_[count_] = positive_data_;
+        weights_[count_++] = dnoise_coeff_ * guidance_scale_;
+    } else {
+        inputs_[count_] = positive_data_;
+        weights_[count_++] = dnoise_coeff_;
+    }
+    if (coeffs_.noise_coeff != 0.0f) {
+        inputs_[count_] = step_noise(data_size_, step_index_);
+        weights_[count_++] = coeffs_.noise_coeff;
+    }
+    KernelHelper::weighted_sum<float>(inputs_, weights_, count_, output_data_, data_size_);
+}
+
+void SchedulerBase::execute_method(
+    const float* predict_data_,
+    const float* samples_data_,
+    float* output_data_,
+    long data_size_,
+    long step_index_,
+    float random_intensity_
+) {
+    StepCoefficients coeffs_{};
+    if (!step_coefficients(step_index_, random_intensity_, coeffs_)) {
+        amon_report(class_exception(EXC_LOG_ERR, "ERROR:: scheduler without step method"));
+        return;
+    }
+
+    const float* inputs_[3] = {samples_data_, predict_data_, nullptr};
+    float weights_[3] = {coeffs_.sample_coeff, coeffs_.predict_coeff, coeffs_.noise_coeff};
+    int count_ = 2;
+    if (coeffs_.noise_coeff != 0.0f) {
+        inputs_[count_++] = step_noise(data_size_, step_index_);
+    }
+    KernelHelper::weighted_sum<float>(inputs_, weights_, count_, output_data_, data_size_);
+}
+
+void SchedulerBase::prefetch(long data_size_, int step_index_, float random_intensity_) {
+    // noise only depends on (seed, step), so it can be made while model runs & step stays arithmetic
+    if (step_index_ >= scheduler_timesteps.size()) { return; }
+    if (!require_noise(step_index_, random_intensity_)) { return; }
+
+    wait_prefetch();
+    if (noise_ahead.size() != size_t(data_size_)) {
+        noise_ahead.resize(data_size_);
+    }
+    if (!noise_worker) { noise_worker = std::make_unique<WorkerPool>(1); }
+    auto task_ = std::make_shared<std::packaged_task<void()>>([this, data_size_, step_index_]() {
+        generate_noise(noise_ahead.data(), data_size_, step_index_);
+    });
+    noise_pending = task_->get_future();
+    noise_pending_step = step_index_;
+    if (!noise_worker->submit([task_]() { (*task_)(); })) {
+        (*task_)();
+    }
+}
+
+void SchedulerBase::wait_prefetch() {
+    if (noise_pending.valid()) { noise_pending.get(); }
+    noise_pending_step = -1;
+}
+
+const float* SchedulerBase::step_noise(long data_size_, long step_index_) {
+    bool prefetched_ = (noise_pending_step == step_index_ && noise_ahead.size() == size_t(data_size_));
+    wait_prefetch();
+    if (prefetched_) {
+        std::swap(scheduler_noise, noise_ahead);
+        return scheduler_noise.data();
+    }
+    if (scheduler_noise.size() != size_t(data_size_)) {
+        scheduler_noise.resize(data_size_);
+    }
+    generate_noise(scheduler_noise.data(), data_size_, step_index_);
+    return scheduler_noise.data();
+}
+
+void SchedulerBase::generate_noise(float* noise_data_, long data_size_, long step_index_) {
+    auto stream_ = uint64_t(step_index_ + 1);
+    if (noise_items.empty() || noise_item_size * long(noise_items.size()) != data_size_) {
+        noise_generator.fill(noise_data_, data_size_, stream_);
+        return;
+    }
+    for (size_t n = 0; n < noise_items.size(); ++n) {
+        noise_items[n].fill(noise_data_ + long(n) * noise_item_size, noise_item_size, stream_);
+    }
 }
 
 void SchedulerBase::uninit() {
+    wait_prefetch();
     scheduler_timesteps.clear();
     scheduler_sigmas.clear();
 }
 
 void SchedulerBase::release() {
+    wait_prefetch();
     alphas_cumprod.clear();
+    scheduler_predict.clear();
+    scheduler_guided.clear();
+    scheduler_noise.clear();
+    noise_ahead.clear();
 }
 
 } // namespace scheduler
@@ -14,22 +14,11 @@ namespace sd {
 namespace scheduler {
 
 class DDIMDiscreteScheduler: public SchedulerBase {
-private:
-    RandomGenerator ddpm_random;
-
 protected:
-    std::vector<float> execute_method(
-        const float* predict_data_,
-        const float* samples_data_,
-        long data_size_,
-        long step_index_,
-        float random_intensity_
-    ) override;
+    bool step_coefficients(long step_index_, float random_intensity_, StepCoefficients &coeffs_) override;
 
 public:
-    explicit DDIMDiscreteScheduler(SchedulerConfig scheduler_config_ = {}) : SchedulerBase(scheduler_config_) {
-        ddpm_random.seed(0);
-    }
+    explicit DDIMDiscreteScheduler(SchedulerConfig scheduler_config_ = {}) : SchedulerBase(scheduler_config_) {}
 
     ~DDIMDiscreteScheduler() override = default;
 };
@@ -65,15 +54,11 @@ public:
  *            \__________________/
  *            "random noise"
  */
-std::vector<float> DDIMDiscreteScheduler::execute_method(
-    const float* predict_data_,
-    const float* samples_data_,
-    long data_size_,
+bool DDIMDiscreteScheduler::step_coefficients(
     long step_index_,
-    float random_intensity_
+    float random_intensity_,
+    StepCoefficients &coeffs_
 ) {
-    std::vector<float> scaled_sample_(data_size_);
-
     // DDIM:: sigma get
     float eta = random_intensity_;      // DDIM use η=0, and when η=1, DDIM degrade to DDPM
     float sigma_curs = scheduler_sigmas[step_index_];
@@ -95,15 +80,12 @@ std::vector<float> DDIMDiscreteScheduler::execute_method(
     }
 
     // DDIM:: current noise decrees
-    for (int i = 0; i < data_size_; i++) {
-        scaled_sample_[i] = samples_data_[i] * factor_a + predict_data_[i] * factor_b;
-        if (variance > 0) { // η=1, DDIM should degrade to DDPM
-            // so when η=1, factor_b = (sigma_next_pow - sigma_curs_pow) / (sigma_curs * std::sqrt(sigma_next_pow + 1));
-            scaled_sample_[i] = scaled_sample_[i] + ddpm_random.next() * variance;
-        }
-    }
-
-    return scaled_sample_;
+    // η=1, DDIM should degrade to DDPM
+    // so when η=1, factor_b = (sigma_next_pow - sigma_curs_pow) / (sigma_curs * std::sqrt(sigma_next_pow + 1));
+    coeffs_.sample_coeff = factor_a;
+    coeffs_.predict_coeff = factor_b;
+    coeffs_.noise_coeff = (variance > 0) ? variance : 0.0f;
+    return true;
 }
 
 /*
@@ -129,11 +111,11 @@ std::vector<float> DDIMDiscreteScheduler::execute_method(
  * //
  * // DDIM:: current noise decrees
  * for (int i = 0; i < data_size_; i++) {
- *     scaled_sample_[i] = (predict_data_[i] - samples_data_[i]) / sigma_curs;      // get dnoised_data
- *     scaled_sample_[i] = predict_data_[i] * factor_a + scaled_sample_[i] * factor_b;
+ *     output_data_[i] = (predict_data_[i] - samples_data_[i]) / sigma_curs;        // get dnoised_data
+ *     output_data_[i] = predict_data_[i] * factor_a + output_data_[i] * factor_b;
  *     if (sigma_next > 0 & eta > 0) { // η=1, DDIM should degrade to DDPM
  *         // so when η=1, factor_b = (sigma_next_pow - sigma_curs_pow) / (sigma_curs * std::sqrt(sigma_next_pow + 1));
- *         scaled_sample_[i] = scaled_sample_[i] + ddpm_random.next() * variance;
+ *         output_data_[i] = output_data_[i] + ddpm_random.next() * variance;
  *     }
  * }
  * </Deprecated>
@@ -14,22 +14,11 @@ namespace sd {
 namespace scheduler {
 
 class DDPMDiscreteScheduler: public SchedulerBase {
-private:
-    RandomGenerator ddpm_random;
-
 protected:
-    std::vector<float> execute_method(
-        const float* predict_data_,
-        const float* samples_data_,
-        long data_size_,
-        long step_index_,
-        float random_intensity_
-    ) override;
+    bool step_coefficients(long step_index_, float random_intensity_, StepCoefficients &coeffs_) override;
 
 public:
-    explicit DDPMDiscreteScheduler(SchedulerConfig scheduler_config_ = {}) : SchedulerBase(scheduler_config_) {
-        ddpm_random.seed(0);
-    }
+    explicit DDPMDiscreteScheduler(SchedulerConfig scheduler_config_ = {}) : SchedulerBase(scheduler_config_) {}
 
     ~DDPMDiscreteScheduler() override = default;
 };
@@ -42,17 +31,11 @@ public:
  *   for the true DDPM Markov property made it cast full inference steps
  *   to get result, as steps in inference needs to be equaled to training
  */
-std::vector<float> DDPMDiscreteScheduler::execute_method(
-    const float* predict_data_,
-    const float* samples_data_,
-    long data_size_,
+bool DDPMDiscreteScheduler::step_coefficients(
     long step_index_,
-    float random_intensity_
+    float random_intensity_,
+    StepCoefficients &coeffs_
 ) {
-    SD_UNUSED(random_intensity_);
-
-    std::vector<float> scaled_sample_(data_size_);
-
     // DDPM method:: sigma get
     float eta = random_intensity_;
     float sigma_curs = scheduler_sigmas[step_index_];
@@ -72,14 +55,10 @@ std::vector<float> DDPMDiscreteScheduler::execute_method(
     }
 
     // DDPM:: current noise decrees
-    for (int i = 0; i < data_size_; i++) {
-        scaled_sample_[i] = samples_data_[i] * factor_a + predict_data_[i] * factor_b;         // derivative_out = (sample - predict_sample) / sigma
-        if (variance > 0) {
-            scaled_sample_[i] = scaled_sample_[i] + ddpm_random.next() * variance;
-        }
-    }
-
-    return scaled_sample_;
+    coeffs_.sample_coeff = factor_a;
+    coeffs_.predict_coeff = factor_b;
+    coeffs_.noise_coeff = (variance > 0) ? variance : 0.0f;
+    return true;
 }
 
 } // namespace scheduler
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2018-2050 SD_Scheduler - Arikan.Li
+ * Created by Arikan.Li on 2024/09/10.
+ */
+#ifndef SCHEDULER_DISCRETE_DPMPP_2M
+#define SCHEDULER_DISCRETE_DPMPP_2M
+
+#include "scheduler_base.cc"
+
+namespace onnx {
+namespace sd {
+namespace scheduler {
+
+class DPMPP2MDiscreteScheduler : public SchedulerBase {
+private:
+    std::vector<float> dpm_denoised_prev;   // denoised of last step, latent sized, reused
+    bool dpm_has_prev = false;
+
+protected:
+    void execute_method(
+        const float* predict_data_,
+        const float* samples_data_,
+        float* output_data_,
+        long data_size_,
+        long step_index_,
+        float random_intensity_
+    ) override;
+
+public:
+    explicit DPMPP2MDiscreteScheduler(SchedulerConfig scheduler_config_ = {}) : SchedulerBase(scheduler_config_){
+    }
+
+    ~DPMPP2MDiscreteScheduler() override = default;
+};
+
+/**
+ * base on: https://github.com/crowsonkb/k-diffusion/blob/master/k_diffusion/sampling.py (sample_dpmpp_2m)
+ *   t = -log(sigma), h = t_next - t
+ *   first & last step:   x_next = (sigma_next / sigma) * x - expm1(-h) * D
+ *   others, r = h_last / h:
+ *                        D' = (1 + 1 / 2r) * D - (1 / 2r) * D_prev
+ *                        x_next = (sigma_next / sigma) * x - expm1(-h) * D'
+ */
+void DPMPP2MDiscreteScheduler::execute_method(
+    const float* predict_data_,
+    const float* samples_data_,
+    float* output_data_,
+    long data_size_,
+    long step_index_,
+    float random_intensity_
+) {
+    SD_UNUSED(random_intensity_);
+
+    if (step_index_ == 0 || dpm_denoised_prev.size() != size_t(data_size_)) {
+        dpm_denoised_prev.assign(data_size_, 0.0f);
+        dpm_has_prev = false;
+    }
+
+    // DPM++ 2M:: sigma get
+    float sigma_curs = scheduler_sigmas[step_index_];
+    float sigma_next = scheduler_sigmas[step_index_ + 1];
+
+    if (sigma_next <= 0) {
+        std::copy(predict_data_, predict_data_ + data_size_, output_data_);
+    } else {
+        double h_ = std::log(double(sigma_curs) / double(sigma_next));
+        double phi_ = -std::expm1(-h_);
+        float sample_coeff_ = sigma_next / sigma_curs;
+        if (dpm_has_prev) {
+            double h_last_ = std::log(double(scheduler_sigmas[step_index_ - 1]) / double(sigma_curs));
+            double r_ = h_last_ / h_;
+            const float* inputs_[3] = {samples_data_, predict_data_, dpm_denoised_prev.data()};
+            float weights_[3] = {
+                sample_coeff_,
+                float(phi_ * (1.0 + 1.0 / (2.0 * r_))),
+                float(-phi_ / (2.0 * r_))
+            };
+            KernelHelper::weighted_sum<float>(inputs_, weights_, 3, output_data_, data_size_);
+        } else {
+            KernelHelper::axpby<float>(sample_coeff_, samples_data_, float(phi_), predict_data_, output_data_, data_size_);
+        }
+    }
+
+    std::copy(predict_data_, predict_data_ + data_size_, dpm_denoised_prev.data());
+    dpm_has_prev = true;
+}
+
+} // namespace scheduler
+} // namespace sd
+} // namespace onnx
+
+#endif //SCHEDULER_DISCRETE_DPMPP_2M
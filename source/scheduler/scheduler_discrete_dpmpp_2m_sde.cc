@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2018-2050 SD_Scheduler - Arikan.Li
+ * Created by Arikan.Li on 2024/09/10.
+ */
+#ifndef SCHEDULER_DISCRETE_DPMPP_2M_SDE
+#define SCHEDULER_DISCRETE_DPMPP_2M_SDE
+
+#include "scheduler_base.cc"
+
+namespace onnx {
+namespace sd {
+namespace scheduler {
+
+class DPMPP2MSDEDiscreteScheduler : public SchedulerBase {
+private:
+    std::vector<float> dpm_denoised_prev;   // denoised of last step, latent sized, reused
+    bool dpm_has_prev = false;
+
+protected:
+    bool require_noise(long step_index_, float random_intensity_) override;
+    void execute_method(
+        const float* predict_data_,
+        const float* samples_data_,
+        float* output_data_,
+        long data_size_,
+        long step_index_,
+        float random_intensity_
+    ) override;
+
+public:
+    explicit DPMPP2MSDEDiscreteScheduler(SchedulerConfig scheduler_config_ = {}) : SchedulerBase(scheduler_config_){
+    }
+
+    ~DPMPP2MSDEDiscreteScheduler() override = default;
+};
+
+bool DPMPP2MSDEDiscreteScheduler::require_noise(long step_index_, float random_intensity_) {
+    return random_intensity_ > 0 && scheduler_sigmas[step_index_ + 1] > 0;
+}
+
+/**
+ * base on: https://github.com/crowsonkb/k-diffusion/blob/master/k_diffusion/sampling.py (sample_dpmpp_2m_sde, midpoint)
+ *   t = -log(sigma), h = t_next - t, eta_h = eta * h (eta as random intensity)
+ *   x_next = (sigma_next / sigma) * exp(-eta_h) * x + (1 - exp(-h - eta_h)) * D
+ *          + 0.5 * (1 - exp(-h - eta_h)) / r * (D - D_prev)              (r = h_last / h, when D_prev)
+ *          + sigma_next * sqrt(1 - exp(-2 * eta_h)) * noise
+ *   last step (sigma_next = 0): x_next = D
+ */
+void DPMPP2MSDEDiscreteScheduler::execute_method(
+    const float* predict_data_,
+    const float* samples_data_,
+    float* output_data_,
+    long data_size_,
+    long step_index_,
+    float random_intensity_
+) {
+    if (step_index_ == 0 || dpm_denoised_prev.size() != size_t(data_size_)) {
+        dpm_denoised_prev.assign(data_size_, 0.0f);
+        dpm_has_prev = false;
+    }
+
+    // DPM++ 2M SDE:: sigma get
+    double eta_ = max(random_intensity_, 0.0f);
+    float sigma_curs = scheduler_sigmas[step_index_];
+    float sigma_next = scheduler_sigmas[step_index_ + 1];
+
+    if (sigma_next <= 0) {
+        std::copy(predict_data_, predict_data_ + data_size_, output_data_);
+    } else {
+        double h_ = std::log(double(sigma_curs) / double(sigma_next));
+        double eta_h_ = eta_ * h_;
+        double phi_ = -std::expm1(-h_ - eta_h_);
+
+        const float* inputs_[4];
+        float weights_[4];
+        int count_ = 0;
+        double denoised_coeff_ = phi_;
+        inputs_[count_] = samples_data_;
+        weights_[count_++] = float(double(sigma_next) / double(sigma_curs) * std::exp(-eta_h_));
+        if (dpm_has_prev) {
+            double h_last_ = std::log(double(scheduler_sigmas[step_index_ - 1]) / double(sigma_curs));
+            double mid_ = 0.5 * phi_ * h_ / h_last_;
+            denoised_coeff_ += mid_;
+            inputs_[count_] = dpm_denoised_prev.data();
+            weights_[count_++] = float(-mid_);
+        }
+        inputs_[count_] = predict_data_;
+        weights_[count_++] = float(denoised_coeff_);
+        if (eta_ > 0) {
+            inputs_[count_] = step_noise(data_size_, step_index_);
+            weights_[count_++] = float(double(sigma_next) * std::sqrt(-std::expm1(-2.0 * eta_h_)));
+        }
+        KernelHelper::weighted_sum<float>(inputs_, weights_, count_, output_data_, data_size_);
+    }
+
+    std::copy(predict_data_, predict_data_ + data_size_, dpm_denoised_prev.data());
+    dpm_has_prev = true;
+}
+
+} // namespace scheduler
+} // namespace sd
+} // namespace onnx
+
+#endif //SCHEDULER_DISCRETE_DPMPP_2M_SDE
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2018-2050 SD_Scheduler - Arikan.Li
+ * Created by Arikan.Li on 2024/09/10.
+ */
+#ifndef SCHEDULER_DISCRETE_DPMPP_3M_SDE
+#define SCHEDULER_DISCRETE_DPMPP_3M_SDE
+
+#include "scheduler_base.cc"
+
+namespace onnx {
+namespace sd {
+namespace scheduler {
+
+class DPMPP3MSDEDiscreteScheduler : public SchedulerBase {
+private:
+    std::vector<float> dpm_denoised_prev[2];    // denoised of last two steps [1 back, 2 back], reused
+    long dpm_history_count = 0;
+
+protected:
+    bool require_noise(long step_index_, float random_intensity_) override;
+    void execute_method(
+        const float* predict_data_,
+        const float* samples_data_,
+        float* output_data_,
+        long data_size_,
+        long step_index_,
+        float random_intensity_
+    ) override;
+
+public:
+    explicit DPMPP3MSDEDiscreteScheduler(SchedulerConfig scheduler_config_ = {}) : SchedulerBase(scheduler_config_){
+    }
+
+    ~DPMPP3MSDEDiscreteScheduler() override = default;
+};
+
+bool DPMPP3MSDEDiscreteScheduler::require_noise(long step_index_, float random_intensity_) {
+    return random_intensity_ > 0 && scheduler_sigmas[step_index_ + 1] > 0;
+}
+
+/**
+ * base on: https://github.com/crowsonkb/k-diffusion/blob/master/k_diffusion/sampling.py (sample_dpmpp_3m_sde)
+ *   t = -log(sigma), h = t_next - t, h_eta = h * (eta + 1) (eta as random intensity)
+ *   x_next = exp(-h_eta) * x + (1 - exp(-h_eta)) * D + phi_2 * d1 - phi_3 * d2
+ *          + sigma_next * sqrt(1 - exp(-2 * eta * h)) * noise
+ *   phi_2 = expm1(-h_eta) / h_eta + 1, phi_3 = phi_2 / h_eta - 0.5
+ *   d1, d2 from divided differences of D over last two steps (r0 = h_1 / h, r1 = h_2 / h),
+ *   only first order term with one history, none on first step. last step (sigma_next = 0): x_next = D
+ */
+void DPMPP3MSDEDiscreteScheduler::execute_method(
+    const float* predict_data_,
+    const float* samples_data_,
+    float* output_data_,
+    long data_size_,
+    long step_index_,
+    float random_intensity_
+) {
+    if (step_index_ == 0 || dpm_denoised_prev[0].size() != size_t(data_size_)) {
+        dpm_denoised_prev[0].assign(data_size_, 0.0f);
+        dpm_denoised_prev[1].assign(data_size_, 0.0f);
+        dpm_history_count = 0;
+    }
+
+    // DPM++ 3M SDE:: sigma get
+    double eta_ = max(random_intensity_, 0.0f);
+    float sigma_curs = scheduler_sigmas[step_index_];
+    float sigma_next = scheduler_sigmas[step_index_ + 1];
+
+    if (sigma_next <= 0) {
+        std::copy(predict_data_, predict_data_ + data_size_, output_data_);
+    } else {
+        double h_ = std::log(double(sigma_curs) / double(sigma_next));
+        double h_eta_ = h_ * (eta_ + 1.0);
+        double phi_2_ = std::expm1(-h_eta_) / h_eta_ + 1.0;
+        double phi_3_ = phi_2_ / h_eta_ - 0.5;
+
+        const float* inputs_[5];
+        float weights_[5];
+        int count_ = 0;
+        double denoised_coeff_ = -std::expm1(-h_eta_);
+        inputs_[count_] = samples_data_;
+        weights_[count_++] = float(std::exp(-h_eta_));
+        if (dpm_history_count >= 2) {
+            double h_1_ = std::log(double(scheduler_sigmas[step_index_ - 1]) / double(sigma_curs));
+            double h_2_ = std::log(double(scheduler_sigmas[step_index_ - 2]) / double(scheduler_sigmas[step_index_ - 1]));
+            double r0_ = h_1_ / h_;
+            double r1_ = h_2_ / h_;
+            // d1_0 = (D - D_1) / r0, d1_1 = (D_1 - D_2) / r1
+            // phi_2 * d1 - phi_3 * d2 = a * d1_0 + b * d1_1
+            double a_ = phi_2_ * (1.0 + r0_ / (r0_ + r1_)) - phi_3_ / (r0_ + r1_);
+            double b_ = (phi_3_ - phi_2_ * r0_) / (r0_ + r1_);
+            denoised_coeff_ += a_ / r0_;
+            inputs_[count_] = dpm_denoised_prev[0].data();
+            weights_[count_++] = float(-a_ / r0_ + b_ / r1_);
+            inputs_[count_] = dpm_denoised_prev[1].data();
+            weights_[count_++] = float(-b_ / r1_);
+        } else if (dpm_history_count == 1) {
+            double h_1_ = std::log(double(scheduler_sigmas[step_index_ - 1]) / double(sigma_curs));
+            double r_ = h_1_ / h_;
+            denoised_coeff_ += phi_2_ / r_;
+            inputs_[count_] = dpm_denoised_prev[0].data();
+            weights_[count_++] = float(-phi_2_ / r_);
+        }
+        inputs_[count_] = predict_data_;
+        weights_[count_++] = float(denoised_coeff_);
+        if (eta_ > 0) {
+            inputs_[count_] = step_noise(data_size_, step_index_);
+            weights_[count_++] = float(double(sigma_next) * std::sqrt(-std::expm1(-2.0 * eta_ * h_)));
+        }
+        KernelHelper::weighted_sum<float>(inputs_, weights_, count_, output_data_, data_size_);
+    }
+
+    // shift history, oldest buffer reused for newest
+    std::swap(dpm_denoised_prev[0], dpm_denoised_prev[1]);
+    std::copy(predict_data_, predict_data_ + data_size_, dpm_denoised_prev[0].data());
+    dpm_history_count = min(dpm_history_count + 1, 2L);
+}
+
+} // namespace scheduler
+} // namespace sd
+} // namespace onnx
+
+#endif //SCHEDULER_DISCRETE_DPMPP_3M_SDE
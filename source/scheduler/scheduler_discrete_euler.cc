@@ -13,13 +13,7 @@ namespace scheduler {
 
 class EulerDiscreteScheduler : public SchedulerBase {
 protected:
-    std::vector<float> execute_method(
-        const float *predict_data_,
-        const float *samples_data_,
-        long data_size_,
-        long step_index_,
-        float random_intensity_
-    ) override;
+    bool step_coefficients(long step_index_, float random_intensity_, StepCoefficients &coeffs_) override;
 
 public:
     explicit EulerDiscreteScheduler(SchedulerConfig scheduler_config_ = {}) : SchedulerBase(scheduler_config_){
@@ -28,17 +22,13 @@ public:
     ~EulerDiscreteScheduler() override = default;
 };
 
-std::vector<float> EulerDiscreteScheduler::execute_method(
-    const float* predict_data_,
-    const float* samples_data_,
-    long data_size_,
+bool EulerDiscreteScheduler::step_coefficients(
     long step_index_,
-    float random_intensity_
+    float random_intensity_,
+    StepCoefficients &coeffs_
 ) {
     SD_UNUSED(random_intensity_);
 
-    std::vector<float> scaled_sample_(data_size_);
-
     // Euler method:: sigma get
     float sigma_curs = scheduler_sigmas[step_index_];
     float sigma_next = scheduler_sigmas[step_index_ + 1];
@@ -48,12 +38,12 @@ std::vector<float> EulerDiscreteScheduler::execute_method(
     }
 
     // Euler method:: current noise decrees
-    for (int i = 0; i < data_size_; i++) {
-        scaled_sample_[i] = (samples_data_[i] - predict_data_[i]) / sigma_curs;         // derivative_out = (sample - predict_sample) / sigma
-        scaled_sample_[i] = (samples_data_[i] + scaled_sample_[i] * sigma_dt);          // previous_down = sample + derivative_out * dt
-    }
-
-    return scaled_sample_;
+    // derivative_out = (sample - predict_sample) / sigma
+    // previous_down = sample + derivative_out * dt
+    coeffs_.sample_coeff = 1.0f + sigma_dt / sigma_curs;
+    coeffs_.predict_coeff = -sigma_dt / sigma_curs;
+    coeffs_.noise_coeff = 0.0f;
+    return true;
 }
 
 } // namespace scheduler
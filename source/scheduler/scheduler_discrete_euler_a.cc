@@ -12,37 +12,22 @@ namespace sd {
 namespace scheduler {
 
 class EulerAncestralDiscreteScheduler : public SchedulerBase {
-private:
-    RandomGenerator euler_a_random;
-
 protected:
-    std::vector<float> execute_method(
-        const float *predict_data_,
-        const float *samples_data_,
-        long data_size_,
-        long step_index_,
-        float random_intensity_
-    ) override;
+    bool step_coefficients(long step_index_, float random_intensity_, StepCoefficients &coeffs_) override;
 
 public:
-    explicit EulerAncestralDiscreteScheduler(SchedulerConfig scheduler_config_ = {}) : SchedulerBase(scheduler_config_){
-        euler_a_random.seed(0);
-    }
+    explicit EulerAncestralDiscreteScheduler(SchedulerConfig scheduler_config_ = {}) : SchedulerBase(scheduler_config_){}
 
     ~EulerAncestralDiscreteScheduler() override = default;
 };
 
-std::vector<float> EulerAncestralDiscreteScheduler::execute_method(
-    const float* predict_data_,
-    const float* samples_data_,
-    long data_size_,
+bool EulerAncestralDiscreteScheduler::step_coefficients(
     long step_index_,
-    float random_intensity_
+    float random_intensity_,
+    StepCoefficients &coeffs_
 ) {
     SD_UNUSED(random_intensity_);
 
-    std::vector<float> scaled_sample_(data_size_);
-
     // Euler method:: sigma get
     float sigma_curs = scheduler_sigmas[step_index_];
     float sigma_next = scheduler_sigmas[step_index_ + 1];
@@ -57,15 +42,13 @@ std::vector<float> EulerAncestralDiscreteScheduler::execute_method(
     }
 
     // Euler Ancestral method:: current noise decrees
-    for (int i = 0; i < data_size_; i++) {
-        scaled_sample_[i] = (samples_data_[i] - predict_data_[i]) / sigma_curs;         // derivative_out = (sample - predict_sample) / sigma
-        scaled_sample_[i] = (samples_data_[i] + scaled_sample_[i] * sigma_dt);          // previous_down = sample + derivative_out * dt
-        if (sigma_next > 0) {
-            scaled_sample_[i] = scaled_sample_[i] + euler_a_random.next() * sigma_up;    // producted_out = previous_down + random_noise * sigma_up
-        }
-    }
-
-    return scaled_sample_;
+    // derivative_out = (sample - predict_sample) / sigma
+    // previous_down = sample + derivative_out * dt
+    // producted_out = previous_down + random_noise * sigma_up
+    coeffs_.sample_coeff = 1.0f + sigma_dt / sigma_curs;
+    coeffs_.predict_coeff = -sigma_dt / sigma_curs;
+    coeffs_.noise_coeff = (sigma_next > 0) ? sigma_up : 0.0f;
+    return true;
 }
 
 } // namespace scheduler
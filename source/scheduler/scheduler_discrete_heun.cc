@@ -18,9 +18,10 @@ private:
 
 protected:
     uint64_t correction_steps(uint64_t inference_steps_) override;
-    std::vector<float> execute_method(
+    void execute_method(
         const float *predict_data_,
         const float *samples_data_,
+        float* output_data_,
         long data_size_,
         long step_index_,
         float random_intensity_
@@ -59,16 +60,16 @@ uint64_t HeunDiscreteScheduler::correction_steps(uint64_t inference_steps_){
     return inference_steps_ * 2 - 1;
 }
 
-std::vector<float> HeunDiscreteScheduler::execute_method(
+void HeunDiscreteScheduler::execute_method(
     const float* predict_data_,
     const float* samples_data_,
+    float* output_data_,
     long data_size_,
     long step_index_,
     float random_intensity_
 ) {
     SD_UNUSED(random_intensity_);
 
-    std::vector<float> scaled_sample_(data_size_);
     bool is_first_order_ = (step_index_ % 2 == 0);
 
     // Heun method:: heun start with euler normal
@@ -87,25 +88,23 @@ std::vector<float> HeunDiscreteScheduler::execute_method(
         for (int i = 0; i < data_size_; i++) {  // needs to be built in local step, order_ recalculate;
             float curs_derivative = (samples_data_[i] - predict_data_[i]) / sigma_curs;
             if (is_first_order_) {
-                scaled_sample_[i] = (samples_data_[i] + curs_derivative * sigma_dt);    // output = sample + derivative_mid * dt
+                output_data_[i] = (samples_data_[i] + curs_derivative * sigma_dt);      // output = sample + derivative_mid * dt
                 prev_derivative[i] = curs_derivative;
                 original_sample[i] = samples_data_[i];
             } else {
-                scaled_sample_[i]  = 0.5f * (prev_derivative[i] + curs_derivative);     // curs_der = (prev_sample - predict_next) / sigma_next
-                scaled_sample_[i] = (original_sample[i] + scaled_sample_[i] * sigma_dt);  // output = sample + derivative_mid * dt
+                output_data_[i]  = 0.5f * (prev_derivative[i] + curs_derivative);       // curs_der = (prev_sample - predict_next) / sigma_next
+                output_data_[i] = (original_sample[i] + output_data_[i] * sigma_dt);    // output = sample + derivative_mid * dt
             }
         }
     } else {
         // Final round use euler normal to calculate
         for (int i = 0; i < data_size_; i++) {
-            scaled_sample_[i] = (samples_data_[i] - predict_data_[i]) / sigma_curs;     // derivative_out = (sample - predict_sample) / sigma
-            scaled_sample_[i] = (samples_data_[i] + scaled_sample_[i] * sigma_dt);      // previous_down = sample + derivative_out * dt
+            output_data_[i] = (samples_data_[i] - predict_data_[i]) / sigma_curs;       // derivative_out = (sample - predict_sample) / sigma
+            output_data_[i] = (samples_data_[i] + output_data_[i] * sigma_dt);          // previous_down = sample + derivative_out * dt
         }
         original_sample.clear();
         prev_derivative.clear();
     }
-
-    return scaled_sample_;
 }
 
 } // namespace scheduler
@@ -12,51 +12,32 @@ namespace sd {
 namespace scheduler {
 
 class LCMDiscreteScheduler : public SchedulerBase {
-private:
-    RandomGenerator lcm_random;
-
 protected:
-    std::vector<float> execute_method(
-        const float *predict_data_,
-        const float *samples_data_,
-        long data_size_,
-        long step_index_,
-        float random_intensity_
-    ) override;
+    bool step_coefficients(long step_index_, float random_intensity_, StepCoefficients &coeffs_) override;
 
 public:
-    explicit LCMDiscreteScheduler(SchedulerConfig scheduler_config_ = {}) : SchedulerBase(scheduler_config_){
-        lcm_random.seed(0);
-    }
+    explicit LCMDiscreteScheduler(SchedulerConfig scheduler_config_ = {}) : SchedulerBase(scheduler_config_){}
 
     ~LCMDiscreteScheduler() override = default;
 };
 
 // base on: https://github.com/huggingface/diffusers/blob/main/src/diffusers/schedulers/scheduling_lcm.py
-std::vector<float> LCMDiscreteScheduler::execute_method(
-    const float* predict_data_,
-    const float* samples_data_,
-    long data_size_,
+bool LCMDiscreteScheduler::step_coefficients(
     long step_index_,
-    float random_intensity_
+    float random_intensity_,
+    StepCoefficients &coeffs_
 ) {
     SD_UNUSED(random_intensity_);
 
-    std::vector<float> scaled_sample_(data_size_);
-
     // LCM method:: sigma get, only next sigma be needed
     float sigma_next = scheduler_sigmas[step_index_ + 1]; // sigma_next prev_timestep(caused by inference is a reversed working flow)
 
     // LCM method:: current noise decrees
-    for (int i = 0; i < data_size_; i++) {
-        if (sigma_next > 0) {
-            scaled_sample_[i] = (predict_data_[i] + lcm_random.next() * sigma_next);       // producted_out = predict_sample + random_noise * sigma_next
-        } else {
-            scaled_sample_[i] = (predict_data_[i]);
-        }
-    }
-
-    return scaled_sample_;
+    // producted_out = predict_sample + random_noise * sigma_next
+    coeffs_.sample_coeff = 0.0f;
+    coeffs_.predict_coeff = 1.0f;
+    coeffs_.noise_coeff = (sigma_next > 0) ? sigma_next : 0.0f;
+    return true;
 }
 
 } // namespace scheduler
@@ -13,15 +13,23 @@ namespace scheduler {
 
 class LMSDiscreteScheduler: public SchedulerBase {
 private:
-    std::vector<std::vector<float>> lms_derivatives;
+    long lms_order = 1;
+    vector<float> lms_coefficients;         // [step][order], filled once in init
+    vector<float> lms_derivatives;          // ring of lms_order latent slots
+    vector<const float*> lms_inputs;
+    vector<float> lms_weights;
+    long lms_head = 0;                      // slot of newest derivative
+    long lms_count = 0;
 
 private:
-    float get_lms_coefficient(long order, long t, int current_order);
+    double get_lms_coefficient(long history_num_, long t, int h);
 
 protected:
-    std::vector<float> execute_method(
+    uint64_t correction_steps(uint64_t inference_steps_) override;
+    void execute_method(
         const float* predict_data_,
         const float* samples_data_,
+        float* output_data_,
         long data_size_,
         long step_index_,
         float random_intensity_
@@ -35,72 +43,92 @@ public:
 };
 
 //python line 135 of scheduling_lms_discrete.py
-float LMSDiscreteScheduler::get_lms_coefficient(long history_num_, long t, int h)
+double LMSDiscreteScheduler::get_lms_coefficient(long history_num_, long t, int h)
 {
-    // Compute a linear multistep coefficient.
-    auto LmsDerivative = [&](float tau)->float {
-        float prod = 1.0;
-        for (int k = 0; k < history_num_; k++) {
-            if (h != k) {
-                prod *= (tau - scheduler_sigmas[t - k]) / (scheduler_sigmas[t - h] - scheduler_sigmas[t - k]);
-            }
+    // Compute a linear multistep coefficient, integral of Lagrange basis h over [sigma_t, sigma_t+1].
+    // Basis expanded in u = tau - sigma_t (better conditioned), then integrated exactly.
+    double lower_ = scheduler_sigmas[t];
+    double upper_ = scheduler_sigmas[t + 1];
+    std::vector<double> poly_(1, 1.0);
+    for (int k = 0; k < history_num_; k++) {
+        if (h == k) { continue; }
+        double denom_ = double(scheduler_sigmas[t - h]) - double(scheduler_sigmas[t - k]);
+        double shift_ = (lower_ - double(scheduler_sigmas[t - k])) / denom_;
+        // poly *= (u + lower - sigma_k) / (sigma_h - sigma_k)
+        poly_.push_back(0.0);
+        for (size_t m = poly_.size() - 1; m > 0; --m) {
+            poly_[m] = poly_[m - 1] / denom_ + poly_[m] * shift_;
         }
-        return prod;
-    };
+        poly_[0] = poly_[0] * shift_;
+    }
 
-    // Calculate integration with encapsulated IntegralHelper
-    int pieces_ = 1000;
-    auto integration_ = IntegralHelper::trapezoidal_integral<float>(
-        LmsDerivative , scheduler_sigmas[t] , scheduler_sigmas[t + 1], pieces_
-    );
+    double width_ = upper_ - lower_;
+    double power_ = width_;
+    double integration_ = 0.0;
+    for (size_t m = 0; m < poly_.size(); ++m) {
+        integration_ += poly_[m] * power_ / double(m + 1);
+        power_ *= width_;
+    }
     return integration_;
 }
 
-std::vector<float> LMSDiscreteScheduler::execute_method(
+uint64_t LMSDiscreteScheduler::correction_steps(uint64_t inference_steps_) {
+    // sigmas fixed after init, so coefficients of every step tabled once here
+    lms_order = max(long(scheduler_config.scheduler_maintain_cache), 1L);
+    lms_coefficients.assign(inference_steps_ * lms_order, 0.0f);
+    for (long t = 0; t < long(inference_steps_); t++) {
+        long history_num = min(t + 1, lms_order);
+        for (int cur_order_ = 0; cur_order_ < history_num; cur_order_++) {
+            lms_coefficients[t * lms_order + cur_order_] = float(get_lms_coefficient(history_num, t, cur_order_));
+        }
+    }
+    lms_inputs.assign(lms_order + 1, nullptr);
+    lms_weights.assign(lms_order + 1, 0.0f);
+    lms_count = 0;
+    return inference_steps_;
+}
+
+void LMSDiscreteScheduler::execute_method(
     const float* predict_data_,
     const float* samples_data_,
+    float* output_data_,
     long data_size_,
     long step_index_,
     float random_intensity_
 ) {
-    std::vector<float> scaled_sample_(data_size_);
-    long maintain_order_ = long(scheduler_config.scheduler_maintain_cache);
+    SD_UNUSED(random_intensity_);
 
     // LMS method:: sigma get
-    long history_num = min(step_index_ + 1, maintain_order_);
+    if (step_index_ == 0 || lms_derivatives.size() != size_t(lms_order * data_size_)) {
+        lms_derivatives.assign(lms_order * data_size_, 0.0f);
+        lms_count = 0;
+    }
+    long history_num = min(step_index_ + 1, lms_order);
     float sigma_curs = scheduler_sigmas[step_index_];
 
     // LMS method:: current noise decrees
-    // 1. Convert to an ODE derivative
-    std::vector<float> cur_derivative_(data_size_);
-    for (int i = 0; i < data_size_; i++) {
-        // derivative_out = (sample - predict_sample) / sigma
-        cur_derivative_[i] = (samples_data_[i] - predict_data_[i]) / sigma_curs;
-    }
-
-    // 2. Record ODE derivative in history (reverse recs)
-    lms_derivatives.insert(lms_derivatives.begin(), cur_derivative_);
-    if (lms_derivatives.size() > maintain_order_) {
-        lms_derivatives.pop_back();
-    }
-
-    // 3. compute linear multistep coefficients
-    std::vector<float> lms_coeffs_(history_num);
-    for (int cur_order_ = 0; cur_order_ < history_num; cur_order_++) {
-        // target_coeffs_derivative = lms_method(...)
-        lms_coeffs_[cur_order_] = get_lms_coefficient(history_num, step_index_, cur_order_);
-    }
+    // 1. Convert to an ODE derivative, recorded in next ring slot (overwrite oldest)
+    lms_head = (lms_count == 0) ? 0 : (lms_head + 1) % lms_order;
+    lms_count = min(lms_count + 1, lms_order);
+    float* cur_derivative_ = lms_derivatives.data() + lms_head * data_size_;
+    // derivative_out = (sample - predict_sample) / sigma
+    KernelHelper::axpby<float>(
+        1.0f / sigma_curs, samples_data_, -1.0f / sigma_curs, predict_data_, cur_derivative_, data_size_
+    );
 
-    // 4. compute previous sample based on the derivative path
-    for (int i = 0; i < data_size_; i++) {
-        // output_latent = sample + sum(lms_coeffs * target_coeffs_derivative)
-        scaled_sample_[i] = samples_data_[i];
-        for (int j = 0; j < history_num; j++) {
-            scaled_sample_[i] += lms_coeffs_[j] * lms_derivatives[j][i];
-        }
+    // 2. previous sample based on the derivative path, coefficients from table (j = 0 newest)
+    // output_latent = sample + sum(lms_coeffs * target_coeffs_derivative)
+    history_num = min(history_num, lms_count);
+    lms_inputs[0] = samples_data_;
+    lms_weights[0] = 1.0f;
+    for (long j = 0; j < history_num; j++) {
+        long slot_ = (lms_head - j + lms_order) % lms_order;
+        lms_inputs[j + 1] = lms_derivatives.data() + slot_ * data_size_;
+        lms_weights[j + 1] = lms_coefficients[step_index_ * lms_order + j];
     }
-
-    return scaled_sample_;
+    KernelHelper::weighted_sum<float>(
+        lms_inputs.data(), lms_weights.data(), int(history_num + 1), output_data_, data_size_
+    );
 }
 
 } // namespace scheduler
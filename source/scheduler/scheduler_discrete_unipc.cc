@@ -15,20 +15,32 @@ namespace scheduler {
 
 class UniPCDiscreteScheduler: public SchedulerBase {
 private:
-    typedef std::vector<float> UniData;
-    std::vector<UniData> history_dnoise;
-    UniData last_samples_;
+    typedef std::vector<double> UniCoeffs;
+    long unipc_order = 1;
+    long unipc_this_order = 1;              // order used by last prediction, corrector follows it
+    long unipc_lower_order_nums = 0;        // warm up, order grows with history
+    long unipc_head = 0;                    // slot of newest model output
+    long unipc_count = 0;
+    std::vector<float> history_dnoise;      // ring of unipc_order data predictions (x0), latent slots
+    std::vector<long> history_steps;        // step index of each slot
+    std::vector<float> last_samples_;       // sample prediction started from
+    std::vector<float> corrected_samples_;
+    std::vector<const float*> unipc_inputs;
+    std::vector<float> unipc_weights;
 
 private:
-    //float get_unipc_beta_snr(float sigma_);
+    double get_unipc_lambda(long step_index_);
     long get_unified_history_count(long step_index_);
-    UniData get_unified_correction(UniData curs_samples_, UniData curs_dnoised_, long prev_index_);
-    UniData get_unified_prediction(UniData cors_samples_, UniData curs_dnoised_, long curs_index_);
+    const float* get_history(long back_);
+    static UniCoeffs solve_unified_rhos(const UniCoeffs &rks_, double hh_, long solve_order_);
+    void get_unified_correction(const float* this_dnoised_, float* output_data_, long data_size_, long curs_index_);
+    void get_unified_prediction(const float* curs_samples_, float* output_data_, long data_size_, long curs_index_);
 
 protected:
-    std::vector<float> execute_method(
+    void execute_method(
         const float* predict_data_,
         const float* samples_data_,
+        float* output_data_,
         long data_size_,
         long step_index_,
         float random_intensity_
@@ -43,69 +55,207 @@ public:
 
 /* Assistant Operations ===================================================*/
 
+double UniPCDiscreteScheduler::get_unipc_lambda(long step_index_){
+    // sigmas here are VE ones (x = x0 + sigma * eps), so lambda = log(alpha / sigma_vp) = -log(sigma)
+    return -std::log(double(scheduler_sigmas[step_index_]));
+}
+
 long UniPCDiscreteScheduler::get_unified_history_count(long step_index_){
-    long maintain_order_ = long(scheduler_config.scheduler_maintain_cache);
-    return min(maintain_order_, step_index_);
+    // lower order for warm up, and at the end of short runs (diffusers lower_order_final)
+    long total_steps_ = long(scheduler_sigmas.size()) - 1;
+    long order_ = unipc_order;
+    if (total_steps_ < 15) {
+        order_ = min(order_, total_steps_ - step_index_);
+    }
+    if (scheduler_sigmas[step_index_ + 1] <= 0) {
+        order_ = 1;     // lambda goes infinite on final sigma 0, only first order defined
+    }
+    return max(min(order_, unipc_lower_order_nums + 1), 1L);
+}
+
+const float* UniPCDiscreteScheduler::get_history(long back_){
+    long slot_ = (unipc_head - back_ + unipc_order) % unipc_order;
+    return history_dnoise.data() + slot_ * long(last_samples_.size());
+}
+
+/**
+ * @details rhos of bh2 variant: R[i][k] = rks[k]^i, b[i] = h_phi_(i+1) * (i+1)! / B_h, B_h = expm1(hh),
+ *          solved on the leading solve_order_ rows & cols (small, gaussian elimination in double).
+ */
+UniPCDiscreteScheduler::UniCoeffs UniPCDiscreteScheduler::solve_unified_rhos(
+    const UniCoeffs &rks_, double hh_, long solve_order_
+){
+    long order_ = long(rks_.size());
+    double h_phi_1_ = std::expm1(hh_);
+    double h_phi_k_ = h_phi_1_ / hh_ - 1.0;
+    double factorial_ = 1.0;
+    double b_h_ = std::expm1(hh_);
+    std::vector<UniCoeffs> matrix_(solve_order_, UniCoeffs(solve_order_ + 1, 0.0));
+    for (long i = 0; i < order_; ++i) {
+        if (i < solve_order_) {
+            for (long k = 0; k < solve_order_; ++k) { matrix_[i][k] = std::pow(rks_[k], double(i)); }
+            matrix_[i][solve_order_] = h_phi_k_ * factorial_ / b_h_;
+        }
+        factorial_ *= double(i + 2);
+        h_phi_k_ = h_phi_k_ / hh_ - 1.0 / factorial_;
+    }
+    for (long c = 0; c < solve_order_; ++c) {
+        long pivot_ = c;
+        for (long r = c + 1; r < solve_order_; ++r) {
+            if (std::fabs(matrix_[r][c]) > std::fabs(matrix_[pivot_][c])) { pivot_ = r; }
+        }
+        std::swap(matrix_[c], matrix_[pivot_]);
+        for (long r = 0; r < solve_order_; ++r) {
+            if (r == c || matrix_[c][c] == 0.0) { continue; }
+            double factor_ = matrix_[r][c] / matrix_[c][c];
+            for (long k = c; k <= solve_order_; ++k) { matrix_[r][k] -= factor_ * matrix_[c][k]; }
+        }
+    }
+    UniCoeffs rhos_(solve_order_, 0.0);
+    for (long c = 0; c < solve_order_; ++c) {
+        rhos_[c] = (matrix_[c][c] != 0.0) ? matrix_[c][solve_order_] / matrix_[c][c] : 0.0;
+    }
+    return rhos_;
 }
 
-UniPCDiscreteScheduler::UniData UniPCDiscreteScheduler::get_unified_correction(
-    UniData curs_samples_, UniData curs_dnoised_, long prev_index_
+/**
+ * UniC (bh2), refine x_t of last prediction with model output at it (this_dnoised_ = M_t):
+ *   x_t = (sigma_t / sigma_s0) * x_s0 - h_phi_1 * m0 - B_h * (sum(rhos_c[k] * D1_k) + rhos_c[-1] * (m_t - m0))
+ *   D1_k = (m_k - m0) / r_k,  r_k = (lambda_sk - lambda_s0) / h
+ */
+void UniPCDiscreteScheduler::get_unified_correction(
+    const float* this_dnoised_, float* output_data_, long data_size_, long curs_index_
 ){
-    long last_order_ = get_unified_history_count(prev_index_);
-    return {};
+    long order_ = unipc_this_order;
+    long prev_index_ = curs_index_ - 1;
+    double lambda_t_ = get_unipc_lambda(curs_index_);
+    double lambda_s0_ = get_unipc_lambda(prev_index_);
+    double h_ = lambda_t_ - lambda_s0_;
+    double hh_ = -h_;
+    double h_phi_1_ = std::expm1(hh_);
+    double b_h_ = std::expm1(hh_);
+
+    UniCoeffs rks_;
+    for (long k = 1; k < order_; ++k) {
+        rks_.push_back((get_unipc_lambda(history_steps[(unipc_head - k + unipc_order) % unipc_order]) - lambda_s0_) / h_);
+    }
+    rks_.push_back(1.0);
+    UniCoeffs rhos_c_ = (order_ == 1) ? UniCoeffs{0.5} : solve_unified_rhos(rks_, hh_, order_);
+
+    int count_ = 0;
+    double m0_weight_ = -h_phi_1_ + b_h_ * rhos_c_[order_ - 1];
+    unipc_inputs[count_] = last_samples_.data();
+    unipc_weights[count_++] = float(std::exp(hh_));                 // sigma_t / sigma_s0
+    unipc_inputs[count_] = this_dnoised_;
+    unipc_weights[count_++] = float(-b_h_ * rhos_c_[order_ - 1]);
+    for (long k = 1; k < order_; ++k) {
+        double w_ = b_h_ * rhos_c_[k - 1] / rks_[k - 1];
+        m0_weight_ += w_;
+        unipc_inputs[count_] = get_history(k);
+        unipc_weights[count_++] = float(-w_);
+    }
+    unipc_inputs[count_] = get_history(0);
+    unipc_weights[count_++] = float(m0_weight_);
+    KernelHelper::weighted_sum<float>(unipc_inputs.data(), unipc_weights.data(), count_, output_data_, data_size_);
 }
 
-UniPCDiscreteScheduler::UniData UniPCDiscreteScheduler::get_unified_prediction(
-    UniData cors_samples_, UniData curs_dnoised_, long curs_index_
+/**
+ * UniP (bh2), from x_s0 = curs_samples_ & newest m0 (already in history):
+ *   x_t = (sigma_t / sigma_s0) * x_s0 - h_phi_1 * m0 - B_h * sum(rhos_p[k] * D1_k)
+ */
+void UniPCDiscreteScheduler::get_unified_prediction(
+    const float* curs_samples_, float* output_data_, long data_size_, long curs_index_
 ){
-    long curs_order_ = get_unified_history_count(curs_index_);
-    return {};
+    long order_ = unipc_this_order;
+    double lambda_t_ = (scheduler_sigmas[curs_index_ + 1] > 0) ?
+                       get_unipc_lambda(curs_index_ + 1) : std::numeric_limits<double>::infinity();
+    double lambda_s0_ = get_unipc_lambda(curs_index_);
+    double h_ = lambda_t_ - lambda_s0_;
+    double hh_ = -h_;
+    double h_phi_1_ = std::expm1(hh_);
+    double b_h_ = std::expm1(hh_);
+
+    UniCoeffs rks_;
+    for (long k = 1; k < order_; ++k) {
+        rks_.push_back((get_unipc_lambda(history_steps[(unipc_head - k + unipc_order) % unipc_order]) - lambda_s0_) / h_);
+    }
+    rks_.push_back(1.0);
+    UniCoeffs rhos_p_;
+    if (order_ == 2) {
+        rhos_p_ = {0.5};
+    } else if (order_ > 2) {
+        rhos_p_ = solve_unified_rhos(rks_, hh_, order_ - 1);
+    }
+
+    int count_ = 0;
+    double m0_weight_ = -h_phi_1_;
+    unipc_inputs[count_] = curs_samples_;
+    unipc_weights[count_++] = float(std::exp(hh_));                 // sigma_t / sigma_s0
+    for (long k = 1; k < order_; ++k) {
+        double w_ = b_h_ * rhos_p_[k - 1] / rks_[k - 1];
+        m0_weight_ += w_;
+        unipc_inputs[count_] = get_history(k);
+        unipc_weights[count_++] = float(-w_);
+    }
+    unipc_inputs[count_] = get_history(0);
+    unipc_weights[count_++] = float(m0_weight_);
+    KernelHelper::weighted_sum<float>(unipc_inputs.data(), unipc_weights.data(), count_, output_data_, data_size_);
 }
 
 /* Essential Operations ===================================================*/
 /**
  * base on: https://arxiv.org/pdf/2302.04867
+ *          https://github.com/huggingface/diffusers/blob/main/src/diffusers/schedulers/scheduling_unipc_multistep.py
+ * data prediction (x0) with bh2, order from scheduler_maintain_cache
  */
-std::vector<float> UniPCDiscreteScheduler::execute_method(
+void UniPCDiscreteScheduler::execute_method(
     const float* predict_data_,
     const float* samples_data_,
+    float* output_data_,
     long data_size_,
     long step_index_,
     float random_intensity_
 ) {
     SD_UNUSED(random_intensity_);
 
-    std::vector<float> next_samples_(data_size_);
-    std::vector<float> curs_dnoised_(data_size_);
-    std::vector<float> curs_samples_(data_size_);
-    long maintain_order_ = long(scheduler_config.scheduler_maintain_cache);
-
-    // UniPC:: sigma get
-    float sigma_curs = scheduler_sigmas[step_index_];
-
-    // UniPC: get current model output as M_t
-    auto [c_skip, c_out, c_unused] = find_predict_params_at(sigma_curs);
-    for (int i = 0; i < data_size_; i++) {
-        curs_dnoised_[i] = (predict_data_[i] - samples_data_[i] * c_skip) / c_out;
-        curs_samples_[i] = samples_data_[i];
+    // UniPC:: reset records on new run, buffers sized once
+    if (step_index_ == 0 || last_samples_.size() != size_t(data_size_)) {
+        unipc_order = max(long(scheduler_config.scheduler_maintain_cache), 1L);
+        history_dnoise.assign(unipc_order * data_size_, 0.0f);
+        history_steps.assign(unipc_order, 0);
+        last_samples_.assign(data_size_, 0.0f);
+        corrected_samples_.assign(data_size_, 0.0f);
+        unipc_inputs.assign(unipc_order + 2, nullptr);
+        unipc_weights.assign(unipc_order + 2, 0.0f);
+        unipc_head = 0;
+        unipc_count = 0;
+        unipc_lower_order_nums = 0;
+        unipc_this_order = 1;
     }
 
-    // UniPC: do unified correction logic
-    curs_samples_ = get_unified_correction(curs_samples_, curs_dnoised_, step_index_ - 1);
+    // UniPC: current model output M_t is the data prediction (predict_data_ = x0)
+    // UniPC: do unified correction logic, x_t refined with M_t (not on first step)
+    if (step_index_ > 0 && unipc_count > 0) {
+        get_unified_correction(predict_data_, corrected_samples_.data(), data_size_, step_index_);
+        std::swap(last_samples_, corrected_samples_);
+    } else {
+        std::copy(samples_data_, samples_data_ + data_size_, last_samples_.data());
+    }
 
-    // UniPC: update history records, insert M_t to records->m[0]
+    // UniPC: update history records, M_t to newest slot
     {
-        history_dnoise.insert(history_dnoise.begin(), curs_dnoised_);
-        if (history_dnoise.size() > maintain_order_) {
-            history_dnoise.pop_back();
-        }
-        last_samples_ = curs_samples_;
+        unipc_head = (unipc_count == 0) ? 0 : (unipc_head + 1) % unipc_order;
+        unipc_count = min(unipc_count + 1, unipc_order);
+        std::copy(predict_data_, predict_data_ + data_size_, history_dnoise.data() + unipc_head * data_size_);
+        history_steps[unipc_head] = step_index_;
     }
 
     // UniPC: do unified prediction logic
-    next_samples_ = get_unified_prediction(curs_samples_, curs_dnoised_, step_index_);
-
-    return next_samples_;
+    unipc_this_order = min(get_unified_history_count(step_index_), unipc_count);
+    get_unified_prediction(last_samples_.data(), output_data_, data_size_, step_index_);
+    if (unipc_lower_order_nums < unipc_order) {
+        unipc_lower_order_nums++;
+    }
 }
 
 } // namespace scheduler
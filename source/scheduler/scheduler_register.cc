@@ -14,6 +14,9 @@
 #include "scheduler_discrete_ddpm.cc"
 #include "scheduler_discrete_ddim.cc"
 #include "scheduler_discrete_unipc.cc"
+#include "scheduler_discrete_dpmpp_2m.cc"
+#include "scheduler_discrete_dpmpp_2m_sde.cc"
+#include "scheduler_discrete_dpmpp_3m_sde.cc"
 
 namespace onnx {
 namespace sd {
@@ -61,6 +64,18 @@ public:
                 result_ptr_ = new UniPCDiscreteScheduler(scheduler_config_);
                 break;
             }
+            case SCHEDULER_DPMPP_2M: {
+                result_ptr_ = new DPMPP2MDiscreteScheduler(scheduler_config_);
+                break;
+            }
+            case SCHEDULER_DPMPP_2M_SDE: {
+                result_ptr_ = new DPMPP2MSDEDiscreteScheduler(scheduler_config_);
+                break;
+            }
+            case SCHEDULER_DPMPP_3M_SDE: {
+                result_ptr_ = new DPMPP3MSDEDiscreteScheduler(scheduler_config_);
+                break;
+            }
             default:{
                 amon_report(class_exception(EXC_LOG_ERR, "ERROR:: selected Scheduler unimplemented"));
                 break;
@@ -28,23 +28,43 @@ private:
         size_t tensor_count_o = 0;
     } OrtMdlMeta;
 
+    // persistent binding & outputs, reused by every execute on same slot
+    typedef struct OrtMdlSlot {
+        std::unique_ptr<Ort::IoBinding> slot_binding;
+        std::vector<Tensor> slot_outputs;
+        int64_t slot_batch = 0;
+    } OrtMdlSlot;
+
 private:
     OrtSession model_session = nullptr;
     OrtMdlPath model_path;
     OrtMdlMeta model_meta{};
+    std::deque<OrtMdlSlot> model_slots;     // deque, growing keeps earlier slot outputs in place
+
+private:
+    OrtMdlSlot& prepare_slot(size_t slot_at_, int64_t batch_size_);
 
 protected:
     void print_model_detail(const Ort::AllocatorWithDefaultOptions& allocator, bool is_input);
-    void execute(std::vector<Tensor>& input_tensors_, std::vector<Tensor>& output_tensors_);
+    void release_slots(size_t slot_from_);
+    void bind(const std::vector<const Tensor*>& input_tensors_, size_t slot_at_ = 0, int64_t batch_size_ = 1);
+    const std::vector<Tensor>& execute(size_t slot_at_ = 0, int64_t batch_size_ = 1);
+    const std::vector<Tensor>& execute(
+        const std::vector<const Tensor*>& input_tensors_, size_t slot_at_ = 0, int64_t batch_size_ = 1
+    );
 
 protected:
-    virtual void generate_output(std::vector<Tensor>& output_tensors_) = 0;
+    /**
+     * @details Provide outputs to be bound, in model output order, outputs not provided (tail ones) are
+     *          never materialised. Called once per slot & batch size, buffers reused across execute.
+     */
+    virtual void generate_output(std::vector<Tensor>& output_tensors_, int64_t batch_size_) = 0;
 
 public:
     explicit ModelBase(std::string model_path_) : model_path(std::move(model_path_)) {};
     virtual ~ModelBase() = default;
 
-    void init(ONNXRuntimeExecutor &ort_executor_);
+    void init(ONNXRuntimeExecutor &ort_executor_, ModelRole model_role_);
     void release(ONNXRuntimeExecutor &ort_executor_);
 };
 
@@ -84,12 +104,12 @@ void ModelBase::print_model_detail(const Ort::AllocatorWithDefaultOptions& alloc
     std::cout << "]" << std::endl;
 }
 
-void ModelBase::init(ONNXRuntimeExecutor &ort_executor_) {
+void ModelBase::init(ONNXRuntimeExecutor &ort_executor_, ModelRole model_role_) {
     if (model_path.empty()) {
         amon_report(class_exception(EXC_LOG_ERR, "ERROR:: model path is NaN"));
         return;
     }
-    model_session = ort_executor_.request_model(model_path);
+    model_session = ort_executor_.request_model(model_path, model_role_);
     if (!model_session) {
         amon_report(class_exception(EXC_LOG_ERR, "ERROR:: model create failed"));
         return;
@@ -114,30 +134,87 @@ void ModelBase::init(ONNXRuntimeExecutor &ort_executor_) {
     std::cout << model_path.c_str() << std::endl;
     print_model_detail(ort_alloc, true);
     print_model_detail(ort_alloc, false);
+
+    // most run batch 1 on slot 0, bind it up front
+    prepare_slot(0, 1);
+}
+
+ModelBase::OrtMdlSlot& ModelBase::prepare_slot(size_t slot_at_, int64_t batch_size_) {
+    if (slot_at_ >= model_slots.size()) {
+        model_slots.resize(slot_at_ + 1);
+    }
+    OrtMdlSlot &slot_ = model_slots[slot_at_];
+    if (slot_.slot_batch == batch_size_ && !slot_.slot_outputs.empty()) {
+        return slot_;
+    }
+
+    slot_.slot_outputs.clear();
+    generate_output(slot_.slot_outputs, batch_size_);
+    slot_.slot_batch = batch_size_;
+    if (!model_session) { return slot_; }
+
+    slot_.slot_binding = std::make_unique<Ort::IoBinding>(*model_session);
+    size_t bound_count_ = min(model_meta.tensor_count_o, slot_.slot_outputs.size());
+    for (size_t i = 0; i < bound_count_; ++i) {
+        slot_.slot_binding->BindOutput(model_meta.tensor_names_o[i].c_str(), slot_.slot_outputs[i]);
+    }
+    return slot_;
+}
+
+void ModelBase::release_slots(size_t slot_from_) {
+    // drop tail slots, outputs generated again on next use (e.g. output shape changed)
+    if (slot_from_ < model_slots.size()) {
+        model_slots.resize(slot_from_);
+    }
 }
 
-void ModelBase::execute(std::vector<Tensor>& input_tensors_, std::vector<Tensor>& output_tensors_) {
+void ModelBase::bind(const std::vector<const Tensor*>& input_tensors_, size_t slot_at_, int64_t batch_size_) {
+    OrtMdlSlot &slot_ = prepare_slot(slot_at_, batch_size_);
     if (!model_session) {
         amon_report(class_exception(EXC_LOG_ERR, "ERROR:: model not found"));
         return;
     }
+    if (input_tensors_.size() < model_meta.tensor_count_i) {
+        amon_report(class_exception(EXC_LOG_ERR, "ERROR:: model inputs not enough"));
+        return;
+    }
     try {
-        Ort::IoBinding io_binding(*model_session);
+        // inputs only referenced by binding (no copy), rebind replaces previous one by name,
+        // nullptr keeps what bound before, so tensors updated in place need binding only once
         for (size_t i = 0; i < model_meta.tensor_count_i; ++i) {
-            io_binding.BindInput(model_meta.tensor_names_i[i].c_str(), input_tensors_[i]);
+            if (input_tensors_[i] == nullptr) { continue; }
+            slot_.slot_binding->BindInput(model_meta.tensor_names_i[i].c_str(), *input_tensors_[i]);
         }
-        for (size_t i = 0; i < model_meta.tensor_count_o; ++i) {
-            io_binding.BindOutput(model_meta.tensor_names_o[i].c_str(), output_tensors_[i]);
-        }
-        model_session->Run(Ort::RunOptions{nullptr}, io_binding);
+    } catch (const Ort::Exception &e) {
+        std::cerr << "ONNX Runtime exception: " << e.what() << std::endl;
+    }
+}
+
+const std::vector<Tensor>& ModelBase::execute(
+    const std::vector<const Tensor*>& input_tensors_, size_t slot_at_, int64_t batch_size_
+) {
+    bind(input_tensors_, slot_at_, batch_size_);
+    return execute(slot_at_, batch_size_);
+}
+
+const std::vector<Tensor>& ModelBase::execute(size_t slot_at_, int64_t batch_size_) {
+    OrtMdlSlot &slot_ = prepare_slot(slot_at_, batch_size_);
+    if (!model_session) {
+        amon_report(class_exception(EXC_LOG_ERR, "ERROR:: model not found"));
+        return slot_.slot_outputs;
+    }
+    try {
+        model_session->Run(Ort::RunOptions{nullptr}, *slot_.slot_binding);
     } catch (const Ort::Exception &e) {
         std::cerr << "ONNX Runtime exception: " << e.what() << std::endl;
     } catch (const std::exception &e) {
         std::cerr << "Standard exception: " << e.what() << std::endl;
     }
+    return slot_.slot_outputs;
 }
 
 void ModelBase::release(ONNXRuntimeExecutor &ort_executor_) {
+    model_slots.clear();
     ort_executor_.release_model(model_session);
     model_session = nullptr;
     model_path.clear();
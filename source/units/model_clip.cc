@@ -20,67 +20,114 @@ using namespace detail;
 
 #define DEFAULT_CLIP_CONFIG                                          \
     {                                                                \
-        /*sd_tokenizer_config*/ DEFAULT_TOKENIZER_CONFIG             \
+        /*sd_tokenizer_config*/ DEFAULT_TOKENIZER_CONFIG,            \
+        /*sd_cache_limit_bytes*/ 64 * 1024 * 1024,                   \
+        /*sd_store_path*/ ""                                         \
     }                                                                \
 
 typedef struct ModelClipConfig {
     TokenizerConfig sd_tokenizer_config;
+    uint64_t sd_cache_limit_bytes;      // embedding LRU cache memory limit, 0 for only pinned
+    std::string sd_store_path;          // persistent embedding store directory, empty for disabled
 } ModelClipConfig ;
 
 class Clip : public ModelBase {
 private:
     ModelClipConfig sd_clip_config;
     TokenizerEntity_ptr sd_tokenizer_p;
+    EmbeddingCache* sd_embedding_cache = nullptr;
+    EmbeddingStore* sd_embedding_store = nullptr;
 
 protected:
-    void generate_output(std::vector<Tensor>& output_tensors_) override;
+    void generate_output(std::vector<Tensor>& output_tensors_, int64_t batch_size_) override;
     Tensor tokenizing(const std::string& prompts_);
+    static std::string chunk_key(const Tensor &tokens_, const Tensor &weight_);
+    static std::string store_salt(
+        const std::string &model_path_, const TokenizerConfig &tokenizer_config_, const std::string &store_root_
+    );
 
 public:
     explicit Clip(const std::string &model_path_,  const ModelClipConfig &clip_config_ = DEFAULT_CLIP_CONFIG);
     ~Clip() override;
 
     Tensor embedding(const std::string& prompts_);
+    void pin(const std::string& prompts_);
+    EmbeddingCacheStatistics cache_statistics() const;
 };
 
 Clip::Clip(const std::string &model_path_, const ModelClipConfig &clip_config_) : ModelBase(model_path_){
     sd_clip_config = clip_config_;
     sd_tokenizer_p = TokenizerRegister::request_tokenizer(clip_config_.sd_tokenizer_config);
     sd_tokenizer_p->init();
+    sd_embedding_cache = new EmbeddingCache(clip_config_.sd_cache_limit_bytes);
+    if (!clip_config_.sd_store_path.empty()) {
+        sd_embedding_store = new EmbeddingStore(
+            clip_config_.sd_store_path,
+            store_salt(model_path_, clip_config_.sd_tokenizer_config, clip_config_.sd_store_path)
+        );
+    }
 }
 
 Clip::~Clip(){
     sd_tokenizer_p->uninit();
     sd_tokenizer_p = TokenizerRegister::recycle_tokenizer(sd_tokenizer_p);
+    delete sd_embedding_cache;
+    sd_embedding_cache = nullptr;
+    delete sd_embedding_store;
+    sd_embedding_store = nullptr;
     sd_clip_config.~ModelClipConfig();
 }
 
-void Clip::generate_output(std::vector<Tensor> &output_tensors_) {
-    {
-        std::vector<float> output_hidden_(
-            sd_clip_config.sd_tokenizer_config.avail_token_size *
-            sd_clip_config.sd_tokenizer_config.major_hidden_dim
-        );
-        TensorShape hidden_shape_ = {
-            1,
-            sd_clip_config.sd_tokenizer_config.avail_token_size,
-            sd_clip_config.sd_tokenizer_config.major_hidden_dim
-        };
-        output_tensors_.emplace_back(TensorHelper::create(hidden_shape_, output_hidden_));
-    }
-    {
-        std::vector<float> output_pooler_(
-            sd_clip_config.sd_tokenizer_config.major_hidden_dim
-        );
-        TensorShape pooler_shape_ = {
-            1,
-            sd_clip_config.sd_tokenizer_config.major_hidden_dim
-        };
-        output_tensors_.emplace_back(TensorHelper::create(pooler_shape_, output_pooler_));
-    }
+void Clip::generate_output(std::vector<Tensor> &output_tensors_, int64_t batch_size_) {
+    // only hidden state used, pooler output left unbound (not materialised)
+    TensorShape hidden_shape_ = {
+        batch_size_,
+        sd_clip_config.sd_tokenizer_config.avail_token_size,
+        sd_clip_config.sd_tokenizer_config.major_hidden_dim
+    };
+    output_tensors_.emplace_back(TensorHelper::allocate<float>(hidden_shape_));
+}
+
+std::string Clip::chunk_key(const Tensor &tokens_, const Tensor &weight_) {
+    size_t tokens_size_ = tokens_.GetTensorTypeAndShapeInfo().GetElementCount();
+    size_t weight_size_ = weight_.GetTensorTypeAndShapeInfo().GetElementCount();
+    std::string key_;
+    key_.append((const char*) tokens_.GetTensorData<int32_t>(), tokens_size_ * sizeof(int32_t));
+    key_.append((const char*) weight_.GetTensorData<float>(), weight_size_ * sizeof(float));
+    return key_;
+}
+
+std::string Clip::store_salt(
+    const std::string &model_path_, const TokenizerConfig &tokenizer_config_, const std::string &store_root_
+) {
+    // anything changes hidden states must change the key
+    std::stringstream salt_;
+    salt_ << EmbeddingStore::fingerprint(model_path_, store_root_) << '|'
+          << int(tokenizer_config_.tokenizer_type) << '|'
+          << EmbeddingStore::fingerprint(tokenizer_config_.tokenizer_dictionary_at, store_root_) << '|'
+          << EmbeddingStore::fingerprint(tokenizer_config_.tokenizer_aggregates_at, store_root_) << '|'
+          << tokenizer_config_.avail_token_count << '|'
+          << tokenizer_config_.avail_token_size << '|'
+          << tokenizer_config_.major_hidden_dim << '|'
+          << tokenizer_config_.major_boundary_factor << '|'
+          << tokenizer_config_.txt_attn_increase_factor << '|'
+          << tokenizer_config_.txt_attn_decrease_factor;
+    return salt_.str();
 }
 
 Tensor Clip::embedding(const std::string& prompts_) {
+    // same prompts seen before, skip tokenize & session
+    Tensor cached_hidden_ = TensorHelper::empty<float>();
+    if (sd_embedding_cache->fetch(CACHE_LEVEL_PROMPT, prompts_, cached_hidden_)) {
+        return cached_hidden_;
+    }
+
+    // catalogue prompts persisted by previous runs / other workers, kept at prompt level once read
+    if (sd_embedding_store && sd_embedding_store->fetch(prompts_, cached_hidden_)) {
+        sd_embedding_cache->store(CACHE_LEVEL_PROMPT, prompts_, cached_hidden_);
+        return cached_hidden_;
+    }
+
     // tokenize prompts
     PairedTokenWeight tokenizer_output_ = sd_tokenizer_p->tokenize(prompts_);
 
@@ -89,22 +136,38 @@ Tensor Clip::embedding(const std::string& prompts_) {
         Tensor &tokens_ = tw_pair_.first;               // [1, 77]
         Tensor &weight_ = tw_pair_.second;              // [1, 77]
 
-        std::vector<Tensor> input_tensors;
-        input_tensors.emplace_back(std::move(tokens_)); // [vocab_size, major_hidden_dim]
-        std::vector<Tensor> output_tensors;             // [1, 77, major_hidden_dim]
-        generate_output(output_tensors);
-        execute(input_tensors, output_tensors);
+        // prompts share chunk (same ids & weights) reuse the weighted hidden
+        std::string chunk_key_ = chunk_key(tokens_, weight_);
+        Tensor chunk_hidden_ = TensorHelper::empty<float>();
+        if (sd_embedding_cache->fetch(CACHE_LEVEL_CHUNK, chunk_key_, chunk_hidden_)) {
+            merged_hidden_.push_back(std::move(chunk_hidden_));
+            continue;
+        }
+
+        const std::vector<Tensor> &output_tensors = execute({&tokens_}, 0, 1);  // [1, 77, major_hidden_dim]
 
         merged_hidden_.push_back(                       // [1, 77, major_hidden_dim]
             TensorHelper::weight<float>(output_tensors[0], weight_, 1, true)
         );
+        sd_embedding_cache->store(CACHE_LEVEL_CHUNK, chunk_key_, merged_hidden_.back());
     }
     // seems not right
     Tensor hidden_state_ = TensorHelper::merge<float>(merged_hidden_, 1);  // [1, 77 * N, major_hidden_dim]
+    sd_embedding_cache->store(CACHE_LEVEL_PROMPT, prompts_, hidden_state_);
+    if (sd_embedding_store) { sd_embedding_store->store(prompts_, hidden_state_); }
 
     return hidden_state_;
 }
 
+void Clip::pin(const std::string& prompts_) {
+    Tensor hidden_state_ = embedding(prompts_);
+    sd_embedding_cache->store(CACHE_LEVEL_PROMPT, prompts_, hidden_state_, true);
+}
+
+EmbeddingCacheStatistics Clip::cache_statistics() const {
+    return sd_embedding_cache->statistics();
+}
+
 } // namespace units
 } // namespace sd
 } // namespace onnx
@@ -26,7 +26,9 @@ using namespace detail;
         /*sd_input_height*/     512,                                 \
         /*sd_input_channel*/    4,                                   \
         /*sd_scale_guidance*/   7.5f,                                \
-        /*sd_random_intensity*/ 1.0f                                 \
+        /*sd_random_intensity*/ 1.0f,                                \
+        /*sd_denoise_strength*/ 1.0f,                                \
+        /*sd_batched_guidance*/ false                                \
     }                                                                \
 
 typedef struct ModelUNetConfig {
@@ -37,21 +39,28 @@ typedef struct ModelUNetConfig {
     uint64_t sd_input_channel;
     float sd_scale_guidance;
     float sd_random_intensity;
+    float sd_denoise_strength;
+    bool sd_batched_guidance;
 } ModelUNetConfig;
 
 class UNet : public ModelBase {
 private:
     ModelUNetConfig sd_unet_config = DEFAULT_UNET_CONFIG;
     SchedulerEntity_ptr sd_scheduler_p;
+    std::atomic<bool> sd_interrupt{false};
 
 protected:
-    void generate_output(std::vector<Tensor>& output_tensors_) override;
+    void generate_output(std::vector<Tensor>& output_tensors_, int64_t batch_size_) override;
 
 public:
     explicit UNet(const std::string &model_path_, const ModelUNetConfig &unet_config_ = DEFAULT_UNET_CONFIG);
     ~UNet() override;
 
-    Tensor inference(const Tensor &embs_positive_,const Tensor &embs_negative_, const Tensor &encoded_img_);
+    void interrupt(bool interrupt_ = true);
+    Tensor inference(
+        const Tensor &embs_positive_, const Tensor &embs_negative_, const Tensor &encoded_img_,
+        const std::vector<int64_t> &seeds_ = {}
+    );
 };
 
 UNet::UNet(const std::string &model_path_, const ModelUNetConfig& unet_config_) : ModelBase(model_path_){
@@ -64,86 +73,139 @@ UNet::~UNet(){
     sd_unet_config.~ModelUNetConfig();
 }
 
-void UNet::generate_output(std::vector<Tensor> &output_tensors_) {
-    std::vector<float> output_hidden_(
-        sd_unet_config.sd_input_width *
-        sd_unet_config.sd_input_height *
-        sd_unet_config.sd_input_channel, 0.0f
-    );
+void UNet::interrupt(bool interrupt_) {
+    sd_interrupt.store(interrupt_);
+}
+
+void UNet::generate_output(std::vector<Tensor> &output_tensors_, int64_t batch_size_) {
     TensorShape hidden_shape_ = {
-        1,
+        batch_size_,
         int64_t(sd_unet_config.sd_input_channel),
         int64_t(sd_unet_config.sd_input_height),
         int64_t(sd_unet_config.sd_input_width)
     };
-    output_tensors_.emplace_back(TensorHelper::create(hidden_shape_, output_hidden_));
+    output_tensors_.emplace_back(TensorHelper::allocate<float>(hidden_shape_));
 }
 
 Tensor UNet::inference(
     const Tensor &embs_positive_,
     const Tensor &embs_negative_,
-    const Tensor &encoded_img_
+    const Tensor &encoded_img_,
+    const std::vector<int64_t> &seeds_
 ) {
     int w_ = int(sd_unet_config.sd_input_width);
     int h_ = int(sd_unet_config.sd_input_height);
     int c_ = int(sd_unet_config.sd_input_channel);
+    int n_ = seeds_.empty() ? 1 : int(seeds_.size());
     const bool need_guidance_ = (sd_unet_config.sd_scale_guidance > 1);
-    const uint64_t working_steps_ = sd_scheduler_p->init(sd_unet_config.sd_inference_steps);
+    // img2img starts from intermediate sigma, scheduler drops skipped steps so mask carries that sigma
+    const float denoise_strength_ = TensorHelper::have_data(encoded_img_) ? sd_unet_config.sd_denoise_strength : 1.0f;
+    const uint64_t working_steps_ = sd_scheduler_p->init(sd_unet_config.sd_inference_steps, denoise_strength_);
+
+    if (!TensorHelper::have_data(embs_positive_)) {
+        amon_report(class_exception(EXC_LOG_ERR, "ERROR:: UNet inference without positive embedding"));
+        sd_scheduler_p->uninit();
+        return TensorHelper::empty<float>();
+    }
+
+    // batched CFG, stack [negative, positive] once, only when both embeddings share the same shape
+    const bool batch_guidance_ = (
+        need_guidance_ && sd_unet_config.sd_batched_guidance &&
+        TensorHelper::have_data(embs_positive_) && TensorHelper::have_data(embs_negative_) &&
+        TensorHelper::get_shape(embs_positive_) == TensorHelper::get_shape(embs_negative_)
+    );
+    const bool with_negative_ = need_guidance_ && TensorHelper::have_data(embs_negative_);
+    const int64_t model_batch_ = batch_guidance_ ? 2 * n_ : n_;
+
+    // double-buffered latents (step reads one, writes the other), scratch holds model input,
+    // all sized up front so denoising steps never allocate
+    TensorShape latent_shape_{n_, c_, h_, w_};
+    const long latent_size_ = long(n_) * c_ * h_ * w_;
+    std::vector<float> latent_buffers_[2] = {
+        std::vector<float>(latent_size_, 0.0f),
+        std::vector<float>(latent_size_, 0.0f)
+    };
+    std::vector<float> latent_scratch_(model_batch_ / n_ * latent_size_, 0.0f);
+    std::vector<int64_t> timestep_value_(1, 0);
+    {
+        Tensor init_mask_ = sd_scheduler_p->mask(latent_shape_, seeds_);
+        const float* mask_data_ = init_mask_.GetTensorData<float>();
+        const float* image_data_ = (TensorHelper::have_data(encoded_img_)) ?
+                                   encoded_img_.GetTensorData<float>() : nullptr;
+        for (long i = 0; i < latent_size_; ++i) {
+            latent_buffers_[0][i] = mask_data_[i] + (image_data_ ? image_data_[i] : 0.0f);
+        }
+    }
+
+    // prompts embedded once, broadcast to [N, 77 * N_embed_num, 768] for all batch items
+    Tensor embs_positive_n_ = TensorHelper::repeat<float>(embs_positive_, n_);
+    Tensor embs_negative_n_ = with_negative_ ?
+                              TensorHelper::repeat<float>(embs_negative_, n_) :
+                              TensorHelper::empty<float>();
+    if (batch_guidance_) {
+        std::vector<Tensor> embs_stacked_;
+        embs_stacked_.emplace_back(std::move(embs_negative_n_));
+        embs_stacked_.emplace_back(std::move(embs_positive_n_));
+        embs_positive_n_ = TensorHelper::merge<float>(embs_stacked_, 0);     // [2N, 77 * N_embed_num, 768]
+    }
 
-    TensorShape latent_shape_{1, c_, h_, w_};
-    std::vector<float> latent_empty_(c_ * h_ * w_, 0.0f);
-    Tensor latents_ = (TensorHelper::have_data(encoded_img_)) ?
-                      TensorHelper::clone<float>(encoded_img_, latent_shape_) :
-                      TensorHelper::create(latent_shape_, latent_empty_);
-    Tensor init_mask_ = sd_scheduler_p->mask(latent_shape_);
-    latents_ = TensorHelper::add<float>(latents_, init_mask_, latent_shape_);
+    // views on persistent buffers, bound once, steps only rewrite buffer contents
+    Tensor model_latent_ = TensorHelper::view<float>(
+        latent_scratch_.data(), TensorShape{model_batch_, c_, h_, w_}
+    );
+    Tensor timestep_ = TensorHelper::view<int64_t>(timestep_value_.data(), TensorShape{1});
+    bind({&model_latent_, &timestep_, &embs_positive_n_}, 0, model_batch_);
+    if (with_negative_ && !batch_guidance_) {
+        bind({&model_latent_, &timestep_, &embs_negative_n_}, 1, model_batch_);
+    }
 
+    int latent_at_ = 0;
     for (int i = 0; i < working_steps_; ++i) {
-        Tensor model_latent_ = sd_scheduler_p->scale(latents_, i);
-        Tensor timestep_ = sd_scheduler_p->time(i);
-
-        // do positive N_pos_embed_num times
-        Tensor pred_positive_ = TensorHelper::create(TensorShape{0}, std::vector<float>{});
-        if (TensorHelper::have_data(embs_positive_)) {
-            std::vector<Tensor> input_tensors;
-            input_tensors.emplace_back(TensorHelper::clone<float_t>(model_latent_));
-            input_tensors.emplace_back(TensorHelper::clone<int64_t>(timestep_));
-            input_tensors.emplace_back(TensorHelper::clone<float_t>(embs_positive_));
-            std::vector<Tensor> output_tensors;
-            generate_output(output_tensors);
-            execute(input_tensors, output_tensors);
-            pred_positive_ = std::move(output_tensors[0]);
+        // interrupted by outside (request cancelled), stop denoising between steps
+        if (sd_interrupt.load()) {
+            sd_scheduler_p->uninit();
+            return TensorHelper::empty<float>();
         }
 
-        // do negative N_neg_embed_num times
-        Tensor pred_negative_ = TensorHelper::create(TensorShape{0}, std::vector<float>{});
-        if (TensorHelper::have_data(embs_negative_) && need_guidance_) {
-            std::vector<Tensor> input_tensors;
-            input_tensors.emplace_back(TensorHelper::clone<float_t>(model_latent_));
-            input_tensors.emplace_back(TensorHelper::clone<int64_t>(timestep_));
-            input_tensors.emplace_back(TensorHelper::clone<float_t>(embs_negative_));
-            std::vector<Tensor> output_tensors;
-            generate_output(output_tensors);
-            execute(input_tensors, output_tensors);
-            pred_negative_ = std::move(output_tensors[0]);
+        const float* latent_curs_ = latent_buffers_[latent_at_].data();
+        float* latent_next_ = latent_buffers_[1 - latent_at_].data();
+        float* scratch_ = latent_scratch_.data();
+        sd_scheduler_p->scale(latent_curs_, scratch_, latent_size_, i);
+        if (batch_guidance_) {
+            std::copy(scratch_, scratch_ + latent_size_, scratch_ + latent_size_);
+        }
+        timestep_value_[0] = sd_scheduler_p->time(i);
+        // step noise made on helper thread while UNet runs, step below only does the arithmetic
+        sd_scheduler_p->prefetch(latent_size_, i, sd_unet_config.sd_random_intensity);
+
+        // predictions point to slot outputs (owned by model, valid until next execute on the slot)
+        const float* pred_positive_ = nullptr;
+        const float* pred_negative_ = nullptr;
+        if (batch_guidance_) {
+            // negative & positive in one batch-2 pass, laid out as [negative, positive]
+            pred_negative_ = execute(0, model_batch_)[0].GetTensorData<float>();
+            pred_positive_ = pred_negative_ + latent_size_;
+        } else {
+            // positive on slot 0, negative on slot 1 so positive result kept
+            pred_positive_ = execute(0, model_batch_)[0].GetTensorData<float>();
+            if (with_negative_) {
+                pred_negative_ = execute(1, model_batch_)[0].GetTensorData<float>();
+            }
         }
 
-        // Merge predictions
+        // Merge predictions, Dnoise & Step, fused into one pass when scheduler allows
         float merge_factor_ = sd_unet_config.sd_scale_guidance;
-        Tensor guided_pred_ = (
-            (need_guidance_) ?
-            TensorHelper::guide<float>(pred_negative_, pred_positive_, merge_factor_) :
-            TensorHelper::clone<float>(pred_positive_, latent_shape_)
+        sd_scheduler_p->step(
+            latent_curs_, pred_negative_, pred_positive_, merge_factor_,
+            latent_next_, latent_size_, i, sd_unet_config.sd_random_intensity
         );
-
-        // Dnoise & Step
-        latents_ = sd_scheduler_p->step(latents_, guided_pred_, i, sd_unet_config.sd_random_intensity);
+        latent_at_ = 1 - latent_at_;
 
         CommonHelper::print_progress_bar(float(i + 1) / float(working_steps_));
     }
 
     sd_scheduler_p->uninit();
-    return latents_;
+    return TensorHelper::create(latent_shape_, latent_buffers_[latent_at_]);
 }
 
 
@@ -22,28 +22,51 @@ using namespace detail;
         /*sd_input_width*/            512,                           \
         /*sd_input_height*/           512,                           \
         /*sd_input_channel*/          4,                             \
+        /*sd_tile_size*/              0,                             \
+        /*sd_tile_overlap*/           0,                             \
+        /*sd_tile_parallel*/          1,                             \
+        /*sd_tile_statistics*/        false,                         \
     }                                                                \
 
+#define VAE_TILE_SLOT_BEGIN         1       // slot 0 for whole input, tile workers from here
+
 typedef struct ModelVAEsConfig {
     float sd_decode_scale_strength;
     uint64_t sd_input_width;
     uint64_t sd_input_height;
     uint64_t sd_input_channel;
+    uint64_t sd_tile_size;              // tile edge on model input, 0 for whole input in one run
+    uint64_t sd_tile_overlap;           // overlap of neighbour tiles on model input, clamped to half tile
+    uint64_t sd_tile_parallel;          // tiles run concurrently, each holds its own slot outputs
+    bool sd_tile_statistics;            // shift each tile output mean to whole input reference
 } ModelVAEsConfig;
 
 class VAE : public ModelBase {
 private:
     ModelVAEsConfig sd_vae_config = DEFAULT_VAEs_CONFIG;
+    Tensor sd_vae_empty = TensorHelper::empty<float>();
+    Tensor sd_vae_tiled = TensorHelper::empty<float>();
+    std::vector<float> sd_vae_tiled_weights;
+    int64_t sd_vae_slot_dims[2] = {0, 0};       // output [H, W] of slots generated next, 0 for config
+    int64_t sd_vae_tile_dims[2] = {0, 0};       // output [H, W] tile slots currently bound with
+
+private:
+    bool tiling(const Tensor &input_) const;
+    void tile_copy(const float* input_data_, const TensorShape &input_shape_, int64_t y_, int64_t x_,
+                   float input_scale_, float* tile_data_, int64_t tile_h_, int64_t tile_w_) const;
+    const Tensor& tiled_execute(const Tensor &input_, float input_scale_);
+    static std::vector<int64_t> tile_offsets(int64_t length_, int64_t tile_, int64_t overlap_);
+    static void tile_ramp(std::vector<float> &ramp_, int64_t length_, int64_t overlap_, bool head_, bool tail_);
 
 protected:
-    void generate_output(std::vector<Tensor> &output_tensors_) override;
+    void generate_output(std::vector<Tensor> &output_tensors_, int64_t batch_size_) override;
 
 public:
     explicit VAE(const std::string &model_path_, const ModelVAEsConfig &vae_config_ = DEFAULT_VAEs_CONFIG);
     ~VAE() override;
 
-    Tensor encode(const Tensor &inimage_);
-    Tensor decode(const Tensor &latents_);
+    Tensor encode(const Tensor &inimage_);      // inimage_ planar RGB already in [-1, 1], tiled when over tile size
+    const Tensor& decode(const Tensor &latents_);  // raw decoder output in [-1, 1], valid until next decode (tiled when input over tile size)
 };
 
 VAE::VAE(const std::string &model_path_, const ModelVAEsConfig &vae_config_) : ModelBase(model_path_){
@@ -54,43 +77,205 @@ VAE::~VAE(){
     sd_vae_config.~ModelVAEsConfig();
 }
 
-void VAE::generate_output(std::vector<Tensor> &output_tensors_) {
-    std::vector<float> output_hidden_(
-        sd_vae_config.sd_input_width *
-        sd_vae_config.sd_input_height *
-        sd_vae_config.sd_input_channel
-    );
+void VAE::generate_output(std::vector<Tensor> &output_tensors_, int64_t batch_size_) {
     TensorShape hidden_shape_ = {
-        1,
+        batch_size_,
         int64_t(sd_vae_config.sd_input_channel),
-        int64_t(sd_vae_config.sd_input_height),
-        int64_t(sd_vae_config.sd_input_width)
+        sd_vae_slot_dims[0] > 0 ? sd_vae_slot_dims[0] : int64_t(sd_vae_config.sd_input_height),
+        sd_vae_slot_dims[1] > 0 ? sd_vae_slot_dims[1] : int64_t(sd_vae_config.sd_input_width)
     };
-    output_tensors_.emplace_back(TensorHelper::create(hidden_shape_, output_hidden_));
+    output_tensors_.emplace_back(TensorHelper::allocate<float>(hidden_shape_));
+}
+
+bool VAE::tiling(const Tensor &input_) const {
+    if (sd_vae_config.sd_tile_size == 0) { return false; }
+    TensorShape input_shape_ = TensorHelper::get_shape(input_);
+    auto tile_ = int64_t(sd_vae_config.sd_tile_size);
+    return input_shape_.size() == 4 && (input_shape_[2] > tile_ || input_shape_[3] > tile_);
+}
+
+std::vector<int64_t> VAE::tile_offsets(int64_t length_, int64_t tile_, int64_t overlap_) {
+    // fixed stride, last tile pushed back flush to the end, so every tile keeps same size (& slot)
+    std::vector<int64_t> offsets_ = {0};
+    int64_t stride_ = max(tile_ - overlap_, int64_t(1));
+    while (offsets_.back() + tile_ < length_) {
+        offsets_.push_back(min(offsets_.back() + stride_, length_ - tile_));
+    }
+    return offsets_;
+}
+
+void VAE::tile_ramp(std::vector<float> &ramp_, int64_t length_, int64_t overlap_, bool head_, bool tail_) {
+    // linear feather on sides facing a neighbour, never 0 so every pixel keeps some weight
+    ramp_.assign(size_t(length_), 1.0f);
+    if (overlap_ <= 0) { return; }
+    for (int64_t i = 0; i < length_; ++i) {
+        if (head_) { ramp_[i] = min(ramp_[i], (float(i) + 0.5f) / float(overlap_)); }
+        if (tail_) { ramp_[i] = min(ramp_[i], (float(length_ - i) - 0.5f) / float(overlap_)); }
+    }
+}
+
+void VAE::tile_copy(
+    const float* input_data_, const TensorShape &input_shape_, int64_t y_, int64_t x_,
+    float input_scale_, float* tile_data_, int64_t tile_h_, int64_t tile_w_
+) const {
+    int64_t in_h_ = input_shape_[2], in_w_ = input_shape_[3];
+    for (int64_t p = 0; p < input_shape_[0] * input_shape_[1]; ++p) {
+        for (int64_t r = 0; r < tile_h_; ++r) {
+            const float* src_ = input_data_ + (p * in_h_ + y_ + r) * in_w_ + x_;
+            float* dst_ = tile_data_ + (p * tile_h_ + r) * tile_w_;
+            for (int64_t c = 0; c < tile_w_; ++c) { dst_[c] = src_[c] * input_scale_; }
+        }
+    }
+}
+
+const Tensor& VAE::tiled_execute(const Tensor &input_, float input_scale_) {
+    TensorShape input_shape_ = TensorHelper::get_shape(input_);
+    int64_t batch_ = input_shape_[0], in_c_ = input_shape_[1], in_h_ = input_shape_[2], in_w_ = input_shape_[3];
+    auto out_c_ = int64_t(sd_vae_config.sd_input_channel);
+    auto out_h_ = int64_t(sd_vae_config.sd_input_height);
+    auto out_w_ = int64_t(sd_vae_config.sd_input_width);
+
+    int64_t tile_h_ = min(int64_t(sd_vae_config.sd_tile_size), in_h_);
+    int64_t tile_w_ = min(int64_t(sd_vae_config.sd_tile_size), in_w_);
+    int64_t overlap_ = min(int64_t(sd_vae_config.sd_tile_overlap), min(tile_h_, tile_w_) / 2);
+    std::vector<int64_t> offsets_y_ = tile_offsets(in_h_, tile_h_, overlap_);
+    std::vector<int64_t> offsets_x_ = tile_offsets(in_w_, tile_w_, overlap_);
+    size_t tile_count_ = offsets_y_.size() * offsets_x_.size();
+    size_t parallel_ = size_t(max(min(sd_vae_config.sd_tile_parallel, uint64_t(tile_count_)), uint64_t(1)));
+
+    // model input to output ratio taken from config, e.g. 8x up for decoder
+    int64_t tile_out_h_ = tile_h_ * out_h_ / in_h_, tile_out_w_ = tile_w_ * out_w_ / in_w_;
+    int64_t overlap_out_h_ = overlap_ * out_h_ / in_h_, overlap_out_w_ = overlap_ * out_w_ / in_w_;
+
+    TensorShape output_shape_ = {batch_, out_c_, out_h_, out_w_};
+    if (!TensorHelper::have_data(sd_vae_tiled) || TensorHelper::get_shape(sd_vae_tiled) != output_shape_) {
+        sd_vae_tiled = TensorHelper::allocate<float>(output_shape_);
+    }
+    float* output_data_ = sd_vae_tiled.GetTensorMutableData<float>();
+    std::fill(output_data_, output_data_ + batch_ * out_c_ * out_h_ * out_w_, 0.0f);
+    sd_vae_tiled_weights.assign(size_t(out_h_ * out_w_), 0.0f);
+
+    // tile slots generated (& bound) here, workers below only run them
+    if (sd_vae_tile_dims[0] != tile_out_h_ || sd_vae_tile_dims[1] != tile_out_w_) {
+        release_slots(VAE_TILE_SLOT_BEGIN);
+        sd_vae_tile_dims[0] = tile_out_h_;
+        sd_vae_tile_dims[1] = tile_out_w_;
+    }
+    std::vector<Tensor> tile_inputs_;
+    sd_vae_slot_dims[0] = tile_out_h_;
+    sd_vae_slot_dims[1] = tile_out_w_;
+    for (size_t k = 0; k < parallel_; ++k) {
+        tile_inputs_.emplace_back(TensorHelper::allocate<float>({batch_, in_c_, tile_h_, tile_w_}));
+        bind({&tile_inputs_.back()}, VAE_TILE_SLOT_BEGIN + k, batch_);
+    }
+    sd_vae_slot_dims[0] = 0;
+    sd_vae_slot_dims[1] = 0;
+
+    const float* input_data_ = input_.GetTensorData<float>();
+
+    // per-tile norms only see their own tile, colour & brightness drift between tiles, so whole input
+    // shrunk to one tile is run first, its output region means serve as reference for each tile
+    std::vector<float> reference_;
+    if (sd_vae_config.sd_tile_statistics) {
+        Tensor shrunk_ = TensorHelper::area_resize<float>(input_, tile_h_, tile_w_);
+        tile_copy(
+            shrunk_.GetTensorData<float>(), TensorHelper::get_shape(shrunk_), 0, 0,
+            input_scale_, tile_inputs_[0].GetTensorMutableData<float>(), tile_h_, tile_w_
+        );
+        const float* shrunk_result_ = execute(VAE_TILE_SLOT_BEGIN, batch_).front().GetTensorData<float>();
+        reference_.assign(shrunk_result_, shrunk_result_ + batch_ * out_c_ * tile_out_h_ * tile_out_w_);
+    }
+
+    std::mutex blend_lock_;
+    auto worker_ = [&](size_t k) {
+        float* tile_data_ = tile_inputs_[k].GetTensorMutableData<float>();
+        std::vector<float> ramp_y_, ramp_x_;
+        std::vector<float> shift_(size_t(batch_ * out_c_), 0.0f);
+        for (size_t t = k; t < tile_count_; t += parallel_) {
+            size_t at_y_ = t / offsets_x_.size(), at_x_ = t % offsets_x_.size();
+            int64_t y_ = offsets_y_[at_y_], x_ = offsets_x_[at_x_];
+            tile_copy(input_data_, input_shape_, y_, x_, input_scale_, tile_data_, tile_h_, tile_w_);
+
+            const Tensor &tile_output_ = execute(VAE_TILE_SLOT_BEGIN + k, batch_).front();
+            const float* tile_result_ = tile_output_.GetTensorData<float>();
+            tile_ramp(ramp_y_, tile_out_h_, overlap_out_h_, at_y_ > 0, at_y_ + 1 < offsets_y_.size());
+            tile_ramp(ramp_x_, tile_out_w_, overlap_out_w_, at_x_ > 0, at_x_ + 1 < offsets_x_.size());
+            int64_t out_y_ = y_ * out_h_ / in_h_, out_x_ = x_ * out_w_ / in_w_;
+
+            if (!reference_.empty()) {
+                // only means aligned, reference lost the detail so its spread is no target
+                int64_t ref_y0_ = out_y_ * tile_out_h_ / out_h_, ref_x0_ = out_x_ * tile_out_w_ / out_w_;
+                int64_t ref_y1_ = max((out_y_ + tile_out_h_) * tile_out_h_ / out_h_, ref_y0_ + 1);
+                int64_t ref_x1_ = max((out_x_ + tile_out_w_) * tile_out_w_ / out_w_, ref_x0_ + 1);
+                for (int64_t p = 0; p < batch_ * out_c_; ++p) {
+                    double tile_sum_ = 0, ref_sum_ = 0;
+                    const float* tile_plane_ = tile_result_ + p * tile_out_h_ * tile_out_w_;
+                    const float* ref_plane_ = reference_.data() + p * tile_out_h_ * tile_out_w_;
+                    for (int64_t i = 0; i < tile_out_h_ * tile_out_w_; ++i) { tile_sum_ += tile_plane_[i]; }
+                    for (int64_t r = ref_y0_; r < ref_y1_; ++r) {
+                        for (int64_t c = ref_x0_; c < ref_x1_; ++c) { ref_sum_ += ref_plane_[r * tile_out_w_ + c]; }
+                    }
+                    shift_[p] = float(
+                        ref_sum_ / double((ref_y1_ - ref_y0_) * (ref_x1_ - ref_x0_)) -
+                        tile_sum_ / double(tile_out_h_ * tile_out_w_)
+                    );
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(blend_lock_);
+            for (int64_t r = 0; r < tile_out_h_; ++r) {
+                float* weight_ = sd_vae_tiled_weights.data() + (out_y_ + r) * out_w_ + out_x_;
+                for (int64_t c = 0; c < tile_out_w_; ++c) { weight_[c] += ramp_y_[r] * ramp_x_[c]; }
+            }
+            for (int64_t p = 0; p < batch_ * out_c_; ++p) {
+                for (int64_t r = 0; r < tile_out_h_; ++r) {
+                    const float* src_ = tile_result_ + (p * tile_out_h_ + r) * tile_out_w_;
+                    float* dst_ = output_data_ + (p * out_h_ + out_y_ + r) * out_w_ + out_x_;
+                    for (int64_t c = 0; c < tile_out_w_; ++c) { dst_[c] += (src_[c] + shift_[p]) * ramp_y_[r] * ramp_x_[c]; }
+                }
+            }
+        }
+    };
+
+    // one session serves concurrent runs, each worker on its own binding & outputs
+    std::vector<std::thread> threads_pool_;
+    for (size_t k = 1; k < parallel_; ++k) {
+        threads_pool_.emplace_back(worker_, k);
+    }
+    worker_(0);
+    for (auto &thread_ : threads_pool_) { thread_.join(); }
+
+    int64_t plane_size_ = out_h_ * out_w_;
+    for (int64_t p = 0; p < batch_ * out_c_; ++p) {
+        float* dst_ = output_data_ + p * plane_size_;
+        for (int64_t i = 0; i < plane_size_; ++i) { dst_[i] /= sd_vae_tiled_weights[i]; }
+    }
+    return sd_vae_tiled;
 }
 
 Tensor VAE::encode(const Tensor &inimage_) {
     if (!TensorHelper::have_data(inimage_)) { return TensorHelper::empty<float>(); }
-    std::vector<Tensor> input_tensors;
-    input_tensors.push_back(TensorHelper::multiple<float>(inimage_, 2.0f, -1.0f));
-    std::vector<Tensor> output_tensors;
-    generate_output(output_tensors);
-    execute(input_tensors, output_tensors);
+    if (tiling(inimage_)) {
+        return TensorHelper::multiple<float>(tiled_execute(inimage_, 1.0f), sd_vae_config.sd_decode_scale_strength);
+    }
+    // normalization fused into pixel conversion, image bound as is
+    const std::vector<Tensor> &output_tensors = execute({&inimage_}, 0, TensorHelper::get_shape(inimage_)[0]);
 
     Tensor result_ = TensorHelper::multiple<float>(output_tensors.front(), sd_vae_config.sd_decode_scale_strength);
     return result_;
 }
 
-Tensor VAE::decode(const Tensor &latents_) {
-    if (!TensorHelper::have_data(latents_)) { return TensorHelper::empty<float>(); }
-    std::vector<Tensor> input_tensors;
-    input_tensors.push_back(TensorHelper::multiple<float>(latents_, (1.0f / sd_vae_config.sd_decode_scale_strength)));
-    std::vector<Tensor> output_tensors;
-    generate_output(output_tensors);
-    execute(input_tensors, output_tensors);
+const Tensor& VAE::decode(const Tensor &latents_) {
+    if (!TensorHelper::have_data(latents_)) { return sd_vae_empty; }
+    if (tiling(latents_)) {
+        // bounded activation memory for large latents, seams feather blended
+        return tiled_execute(latents_, (1.0f / sd_vae_config.sd_decode_scale_strength));
+    }
+    Tensor input_tensor_ = TensorHelper::multiple<float>(latents_, (1.0f / sd_vae_config.sd_decode_scale_strength));
+    const std::vector<Tensor> &output_tensors = execute({&input_tensor_}, 0, TensorHelper::get_shape(latents_)[0]);
 
-    Tensor result_ = TensorHelper::divide<float>(output_tensors.front(), 2.0f, +0.5f, true);
-    return result_;
+    // no (x / 2 + 0.5) pass here, folded into pixel quantization by caller
+    return output_tensors.front();
 }
 
 
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2018-2050 SD_TestFixtures - Arikan.Li
+# Created by Arikan.Li on 2024/09/15.
+#
+# Reference trajectories for test_unipc_trajectory.cc, UniPC bh2 (data prediction) transcribed
+# from diffusers scheduling_unipc_multistep.py in VP space, all in double precision.
+#
+# Sigmas come from the scheduler (the "S" row of each case is kept), only the "X" rows are
+# regenerated, so rerun after an intended change of the UniPC update:
+#     python3 unipc_trajectories.py unipc_trajectories.txt
+#
+import math
+import struct
+import sys
+
+LATENT_SIZE = 5
+
+
+def to_float(value_):
+    return struct.unpack('f', struct.pack('f', value_))[0]
+
+
+def denoise(x_, sigma_):
+    # synthetic nonlinear denoiser shared with the test, x0 from VE sample
+    return [v / (1.0 + sigma_ * sigma_) + 0.1 * math.sin(v) for v in x_]
+
+
+def solve(matrix_, rhs_):
+    n_ = len(rhs_)
+    m_ = [matrix_[i][:] + [rhs_[i]] for i in range(n_)]
+    for c in range(n_):
+        p_ = max(range(c, n_), key=lambda r: abs(m_[r][c]))
+        m_[c], m_[p_] = m_[p_], m_[c]
+        for r in range(n_):
+            if r != c:
+                f_ = m_[r][c] / m_[c][c]
+                m_[r] = [m_[r][k] - f_ * m_[c][k] for k in range(n_ + 1)]
+    return [m_[i][n_] / m_[i][i] for i in range(n_)]
+
+
+def bh2_system(rks_, hh_, order_):
+    h_phi_1_ = math.expm1(hh_)
+    h_phi_k_ = h_phi_1_ / hh_ - 1.0
+    factorial_ = 1.0
+    b_h_ = math.expm1(hh_)
+    r_, b_ = [], []
+    for i in range(1, order_ + 1):
+        r_.append([rk ** (i - 1) for rk in rks_])
+        b_.append(h_phi_k_ * factorial_ / b_h_)
+        factorial_ *= i + 1
+        h_phi_k_ = h_phi_k_ / hh_ - 1.0 / factorial_
+    return r_, b_, b_h_, h_phi_1_
+
+
+def trajectory(sigmas_, order_):
+    steps_ = len(sigmas_) - 1
+    alphas_ = [1.0 / math.sqrt(1.0 + s * s) for s in sigmas_]
+    sigmas_vp_ = [s * a for s, a in zip(sigmas_, alphas_)]
+    lambdas_ = [math.log(a) - math.log(s) if s > 0 else math.inf for a, s in zip(alphas_, sigmas_vp_)]
+
+    x_ = [to_float((k - 2) * sigmas_[0] * 0.7) * alphas_[0] for k in range(LATENT_SIZE)]
+    outputs_ = [None] * order_
+    last_, this_order_, lower_order_nums_ = None, 1, 0
+    rows_ = []
+    for i in range(steps_):
+        m_ = denoise([v / alphas_[i] for v in x_], sigmas_[i])
+        if i > 0 and last_ is not None:
+            # UniC
+            o_ = this_order_
+            m0_ = outputs_[-1]
+            h_ = lambdas_[i] - lambdas_[i - 1]
+            rks_, d1s_ = [], []
+            for k in range(1, o_):
+                rk_ = (lambdas_[i - (k + 1)] - lambdas_[i - 1]) / h_
+                rks_.append(rk_)
+                d1s_.append([(a - b) / rk_ for a, b in zip(outputs_[-(k + 1)], m0_)])
+            rks_.append(1.0)
+            r_, b_, b_h_, h_phi_1_ = bh2_system(rks_, -h_, o_)
+            rhos_c_ = [0.5] if o_ == 1 else solve(r_, b_)
+            x_t_ = [sigmas_vp_[i] / sigmas_vp_[i - 1] * xl - alphas_[i] * h_phi_1_ * m0
+                    for xl, m0 in zip(last_, m0_)]
+            corr_ = [sum(rhos_c_[k] * d1s_[k][e] for k in range(len(d1s_))) for e in range(LATENT_SIZE)]
+            d1_t_ = [a - b for a, b in zip(m_, m0_)]
+            x_ = [a - alphas_[i] * b_h_ * (c + rhos_c_[-1] * d) for a, c, d in zip(x_t_, corr_, d1_t_)]
+        outputs_ = outputs_[1:] + [m_]
+
+        this_order_ = min(order_, steps_ - i) if steps_ < 15 else order_
+        if sigmas_[i + 1] <= 0:
+            this_order_ = 1
+        this_order_ = min(this_order_, lower_order_nums_ + 1)
+        last_ = x_
+
+        # UniP
+        o_ = this_order_
+        m0_ = outputs_[-1]
+        h_ = lambdas_[i + 1] - lambdas_[i]
+        if math.isinf(h_):
+            x_ = m0_[:]
+        else:
+            rks_, d1s_ = [], []
+            for k in range(1, o_):
+                rk_ = (lambdas_[i - k] - lambdas_[i]) / h_
+                rks_.append(rk_)
+                d1s_.append([(a - b) / rk_ for a, b in zip(outputs_[-(k + 1)], m0_)])
+            rks_.append(1.0)
+            r_, b_, b_h_, h_phi_1_ = bh2_system(rks_, -h_, o_)
+            x_ = [sigmas_vp_[i + 1] / sigmas_vp_[i] * xv - alphas_[i + 1] * h_phi_1_ * m0
+                  for xv, m0 in zip(x_, m0_)]
+            if d1s_:
+                rhos_p_ = [0.5] if o_ == 2 else solve([r[:-1] for r in r_[:-1]], b_[:-1])
+                x_ = [a - alphas_[i + 1] * b_h_ * sum(rhos_p_[k] * d1s_[k][e] for k in range(len(d1s_)))
+                      for e, a in enumerate(x_)]
+        if lower_order_nums_ < order_:
+            lower_order_nums_ += 1
+        rows_.append([v / alphas_[i + 1] if alphas_[i + 1] > 0 else v for v in x_])
+    return rows_
+
+
+def main(path_):
+    with open(path_) as f:
+        lines_ = f.read().split('\n')
+    header_ = [l for l in lines_ if l.startswith('#')]
+    cases_ = []
+    for i, line_ in enumerate(lines_):
+        if line_.startswith('T '):
+            steps_, order_ = (int(v) for v in line_.split()[1:3])
+            sigmas_ = [float(v) for v in lines_[i + 1].split()[1:]]
+            cases_.append((steps_, order_, lines_[i + 1], sigmas_))
+    with open(path_, 'w') as f:
+        f.write('\n'.join(header_) + '\n')
+        for steps_, order_, sigma_row_, sigmas_ in cases_:
+            f.write('T %d %d\n%s\n' % (steps_, order_, sigma_row_))
+            for row_ in trajectory(sigmas_, order_):
+                f.write('X ' + ' '.join('%.17g' % v for v in row_) + '\n')
+
+
+if __name__ == '__main__':
+    main(sys.argv[1] if len(sys.argv) > 1 else 'unipc_trajectories.txt')
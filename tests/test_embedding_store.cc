@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2018-2050 SD_TestEmbeddingStore - Arikan.Li
+ * Created by Arikan.Li on 2024/09/17.
+ */
+#include "onnxsd_foundation.cc"
+#include "test_entry.h"
+
+#include <filesystem>
+
+using namespace onnx::sd::base;
+
+#define TEST_STORE_PROMPTS          256
+
+static std::string digest_name(const std::string &material_) {
+    StoreDigest hasher_;
+    hasher_.update(material_.data(), material_.size());
+    uint64_t digest_[2];
+    hasher_.finish(digest_);
+    char name_[40];
+    snprintf(name_, sizeof(name_), "%016llx%016llx", (unsigned long long) digest_[0], (unsigned long long) digest_[1]);
+    return name_;
+}
+
+static void test_digest() {
+    // FIPS 180-4 vectors, leading 128 bits
+    TEST_CHECK(digest_name("") == "e3b0c44298fc1c149afbf4c8996fb924", "empty: %s", digest_name("").c_str());
+    TEST_CHECK(digest_name("abc") == "ba7816bf8f01cfea414140de5dae2223", "abc: %s", digest_name("abc").c_str());
+    std::string two_blocks_ = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    TEST_CHECK(digest_name(two_blocks_) == "248d6a61d20638b8e5c026930c3e6039", "56 bytes: %s", digest_name(two_blocks_).c_str());
+
+    // streamed in uneven pieces gives the same as one shot
+    std::string million_(1000000, 'a');
+    StoreDigest hasher_;
+    for (size_t at_ = 0; at_ < million_.size(); at_ += 777) {
+        hasher_.update(million_.data() + at_, min(size_t(777), million_.size() - at_));
+    }
+    uint64_t digest_[2];
+    hasher_.finish(digest_);
+    TEST_CHECK(digest_[0] == 0xCDC76E5C9914FB92ULL && digest_[1] == 0x81A1C7E284D73E67ULL,
+               "million a: %016llx%016llx", (unsigned long long) digest_[0], (unsigned long long) digest_[1]);
+}
+
+#ifdef __linux__
+static long open_mappings() {
+    std::ifstream maps_("/proc/self/maps");
+    std::string line_;
+    long count_ = 0;
+    while (std::getline(maps_, line_)) { count_ += (line_.find(".emb") != std::string::npos) ? 1 : 0; }
+    return count_;
+}
+#endif
+
+static void test_round_trip() {
+    std::string root_ = (std::filesystem::temp_directory_path() / "adi_test_embedding_store").string();
+    std::filesystem::remove_all(root_);
+    {
+        EmbeddingStore store_(root_, "salt");
+        for (int i = 0; i < TEST_STORE_PROMPTS; ++i) {
+            std::vector<float> value_(77 * 8, float(i));
+            TEST_CHECK(store_.store("prompt " + std::to_string(i), TensorHelper::create<float>({1, 77, 8}, value_)),
+                       "store prompt %d failed", i);
+        }
+
+        std::vector<Tensor> hits_;
+        for (int i = 0; i < TEST_STORE_PROMPTS; ++i) {
+            Tensor hit_ = TensorHelper::empty<float>();
+            TEST_CHECK(store_.fetch("prompt " + std::to_string(i), hit_), "fetch prompt %d missed", i);
+            TEST_CHECK(TensorHelper::get_shape(hit_) == TensorShape({1, 77, 8}) && hit_.GetTensorData<float>()[76] == float(i),
+                       "prompt %d read back wrong", i);
+            hits_.push_back(std::move(hit_));
+        }
+#ifdef __linux__
+        // every hit still alive, none of them holds a mapping
+        TEST_CHECK(open_mappings() == 0, "%ld store files still mapped", open_mappings());
+#endif
+
+        Tensor miss_ = TensorHelper::empty<float>();
+        TEST_CHECK(!store_.fetch("never stored", miss_), "unknown prompt hit");
+        EmbeddingStore other_salt_(root_, "other salt");
+        TEST_CHECK(!other_salt_.fetch("prompt 0", miss_), "prompt hit under another salt");
+    }
+    std::filesystem::remove_all(root_);
+}
+
+int main() {
+    test_digest();
+    test_round_trip();
+    printf("test_embedding_store passed\n");
+    return 0;
+}
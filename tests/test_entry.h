@@ -0,0 +1,22 @@
+/*
+ * Copyright (c) 2018-2050 SD_TestEntry - Arikan.Li
+ * Created by Arikan.Li on 2024/09/14.
+ */
+#ifndef ONNX_SD_TEST_ENTRY_ONCE
+#define ONNX_SD_TEST_ENTRY_ONCE
+
+#include <cstdio>
+#include <cstdlib>
+
+// each test is its own executable, registered to ctest, non-zero exit for failure
+#define TEST_CHECK(condition_, ...)                                             \
+    do {                                                                        \
+        if (!(condition_)) {                                                    \
+            fprintf(stderr, "[FAILED] %s:%d: %s\n", __FILE__, __LINE__, #condition_); \
+            fprintf(stderr, "         " __VA_ARGS__);                           \
+            fprintf(stderr, "\n");                                              \
+            exit(1);                                                            \
+        }                                                                       \
+    } while (0)
+
+#endif  // ONNX_SD_TEST_ENTRY_ONCE
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2018-2050 SD_TestSchedulerSeed - Arikan.Li
+ * Created by Arikan.Li on 2024/09/17.
+ */
+#include "scheduler_register.cc"
+#include "test_entry.h"
+
+using namespace onnx::sd::scheduler;
+
+#define TEST_SEED_STEPS             4
+
+// initial mask & step noise of one run, the way UNet drives the scheduler
+static std::vector<float> run_noise(SchedulerBase &scheduler_) {
+    TensorShape latent_shape_ = {1, 4, 8, 8};
+    long latent_size_ = 4 * 8 * 8;
+    scheduler_.init(TEST_SEED_STEPS);
+    Tensor mask_ = scheduler_.mask(latent_shape_, {});
+    const float* mask_data_ = mask_.GetTensorData<float>();
+    std::vector<float> noise_(mask_data_, mask_data_ + latent_size_);
+
+    std::vector<float> sample_(latent_size_, 0.0f), dnoise_(latent_size_, 0.0f), output_(latent_size_);
+    for (int i = 0; i < TEST_SEED_STEPS; ++i) {
+        scheduler_.prefetch(latent_size_, i);
+        scheduler_.step(sample_.data(), dnoise_.data(), output_.data(), latent_size_, i);
+        noise_.insert(noise_.end(), output_.begin(), output_.end());
+    }
+    scheduler_.uninit();
+    return noise_;
+}
+
+static void test_seed(int64_t seed_, bool expect_same_) {
+    SchedulerConfig config_ = DEFAULT_SCHEDULER_CONFIG;
+    config_.scheduler_type = SCHEDULER_EULER_A;    // stochastic, step noise shows in output
+    config_.scheduler_seed = seed_;
+    EulerAncestralDiscreteScheduler scheduler_(config_);
+    scheduler_.create();
+
+    std::vector<float> first_ = run_noise(scheduler_);
+    std::vector<float> second_ = run_noise(scheduler_);
+    bool same_ = (first_ == second_);
+    TEST_CHECK(same_ == expect_same_, "seed %lld: two runs on one scheduler %s",
+               (long long) seed_, same_ ? "are identical" : "differ");
+}
+
+int main() {
+    test_seed(42, true);        // explicit seed, every run reproduces
+    test_seed(-1, false);       // random seed, every run new
+    printf("test_scheduler_seed passed\n");
+    return 0;
+}
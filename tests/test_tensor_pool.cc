@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2018-2050 SD_TestTensorPool - Arikan.Li
+ * Created by Arikan.Li on 2024/09/14.
+ */
+#include "onnxsd_foundation.cc"
+#include "test_entry.h"
+
+using namespace onnx::sd::base;
+
+#define TEST_POOL_WARMUP_ROUNDS     4
+#define TEST_POOL_STEADY_ROUNDS     64
+
+// one denoise-like round of TensorHelper ops, every tensor released at the end of round
+static void run_round(const NoiseGenerator &noise_, uint64_t round_) {
+    TensorShape latent_shape_ = {1, 4, 64, 64};
+    TensorShape hidden_shape_ = {1, 77, 768};
+
+    Tensor latent_ = TensorHelper::random<float>(latent_shape_, noise_, 1.0f, round_);
+    Tensor positive_ = TensorHelper::multiple<float>(latent_, 0.5f, 0.1f);
+    Tensor negative_ = TensorHelper::divide<float>(latent_, 2.0f);
+    Tensor guided_ = TensorHelper::guide<float>(positive_, negative_, 7.5f);
+    Tensor added_ = TensorHelper::add<float>(guided_, latent_, latent_shape_);
+    Tensor subbed_ = TensorHelper::sub<float>(added_, negative_, latent_shape_);
+    Tensor cloned_ = TensorHelper::clone<float>(subbed_);
+    Tensor batched_ = TensorHelper::duplicate<float>(cloned_);
+    std::vector<Tensor> halves_ = TensorHelper::split<float>(batched_, latent_shape_);
+    Tensor summed_ = TensorHelper::sum<float>(halves_.data(), long(halves_.size()), latent_shape_);
+    Tensor shrunk_ = TensorHelper::area_resize<float>(summed_, 32, 32);
+
+    std::vector<float> hidden_value_(77 * 768, 0.25f);
+    std::vector<float> weight_value_(77, 1.1f);
+    Tensor hidden_ = TensorHelper::create<float>(hidden_shape_, hidden_value_);
+    Tensor weights_ = TensorHelper::create<float>({1, 77}, weight_value_);
+    Tensor weighted_ = TensorHelper::weight<float>(hidden_, weights_, 1, true);
+    std::vector<Tensor> pair_;
+    pair_.emplace_back(std::move(weighted_));
+    pair_.emplace_back(std::move(hidden_));
+    Tensor merged_ = TensorHelper::merge<float>(pair_, 0);
+
+    TEST_CHECK(TensorHelper::get_shape(merged_)[0] == 2, "merge gave batch %lld", (long long) TensorHelper::get_shape(merged_)[0]);
+    TEST_CHECK(TensorHelper::get_shape(shrunk_)[3] == 32, "area_resize gave width %lld", (long long) TensorHelper::get_shape(shrunk_)[3]);
+}
+
+static void test_steady_state() {
+    TensorPool &pool_ = TensorPool::instance();
+    NoiseGenerator noise_(42);
+
+    for (uint64_t i = 0; i < TEST_POOL_WARMUP_ROUNDS; ++i) { run_round(noise_, i); }
+    TensorPoolStatistics warm_ = pool_.statistics();
+    uint64_t warm_fresh_ = warm_.pool_requests - warm_.pool_reuses;
+
+    for (uint64_t i = 0; i < TEST_POOL_STEADY_ROUNDS; ++i) {
+        run_round(noise_, TEST_POOL_WARMUP_ROUNDS + i);
+        TensorPoolStatistics now_ = pool_.statistics();
+        uint64_t now_fresh_ = now_.pool_requests - now_.pool_reuses;
+        // nothing live between rounds, idle set no larger, & no block taken from system again
+        TEST_CHECK(now_.pool_used_bytes == warm_.pool_used_bytes,
+                   "round %llu: used bytes %llu, after warm-up %llu",
+                   (unsigned long long) i, (unsigned long long) now_.pool_used_bytes, (unsigned long long) warm_.pool_used_bytes);
+        TEST_CHECK(now_.pool_retained_bytes <= warm_.pool_retained_bytes,
+                   "round %llu: retained bytes %llu grew over %llu",
+                   (unsigned long long) i, (unsigned long long) now_.pool_retained_bytes, (unsigned long long) warm_.pool_retained_bytes);
+        TEST_CHECK(now_fresh_ == warm_fresh_,
+                   "round %llu: %llu system allocations, after warm-up %llu",
+                   (unsigned long long) i, (unsigned long long) now_fresh_, (unsigned long long) warm_fresh_);
+    }
+    printf("steady state: %llu B retained, %llu requests, %llu reused\n",
+           (unsigned long long) pool_.statistics().pool_retained_bytes,
+           (unsigned long long) pool_.statistics().pool_requests,
+           (unsigned long long) pool_.statistics().pool_reuses);
+}
+
+static void test_class_rounding() {
+    TensorPool pool_(0);                // nothing retained, blocks go back to system on release
+    std::mt19937_64 random_(7);
+    for (int i = 0; i < 4096; ++i) {
+        size_t bytes_ = size_t(random_() % (uint64_t(64) << 20)) + 1;
+        void* data_ = pool_.acquire(bytes_);
+        uint64_t used_ = pool_.statistics().pool_used_bytes;
+        // under 25% over request (+ smallest class for tiny ones)
+        TEST_CHECK(used_ >= bytes_ && used_ <= bytes_ + bytes_ / 4 + 256,
+                   "request %zu B held %llu B", bytes_, (unsigned long long) used_);
+        pool_.release(data_);
+    }
+
+    // VAE decoder output [1, 3, 512, 512] float fits its class exactly
+    void* decoded_ = pool_.acquire(size_t(3) * 512 * 512 * sizeof(float));
+    TEST_CHECK(pool_.statistics().pool_used_bytes == uint64_t(3) * 512 * 512 * sizeof(float),
+               "decoder output held %llu B", (unsigned long long) pool_.statistics().pool_used_bytes);
+    pool_.release(decoded_);
+}
+
+int main() {
+    test_class_rounding();
+    test_steady_state();
+    printf("test_tensor_pool passed\n");
+    return 0;
+}
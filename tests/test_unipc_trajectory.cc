@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2018-2050 SD_TestUniPCTrajectory - Arikan.Li
+ * Created by Arikan.Li on 2024/09/15.
+ */
+#include "scheduler_register.cc"
+#include "test_entry.h"
+
+#include <fstream>
+#include <sstream>
+
+using namespace onnx::sd::scheduler;
+
+#define TEST_UNIPC_FIXTURE          "fixtures/unipc_trajectories.txt"
+#define TEST_UNIPC_LATENT_SIZE      5
+#define TEST_UNIPC_TOLERANCE        1e-6        // orders 1 to 3
+#define TEST_UNIPC_TOLERANCE_HIGH   1e-5        // order 4, larger rhos amplify float rounding
+
+typedef struct UniPCTrajectory {
+    long steps;
+    long order;
+    std::vector<double> sigmas;
+    std::vector<std::vector<double>> samples;   // sample after each step
+} UniPCTrajectory;
+
+class UniPCTestScheduler : public UniPCDiscreteScheduler {
+public:
+    explicit UniPCTestScheduler(const SchedulerConfig &scheduler_config_) : UniPCDiscreteScheduler(scheduler_config_) {}
+    const vector<float>& sigmas() const { return scheduler_sigmas; }
+};
+
+static std::vector<UniPCTrajectory> load_fixture(const std::string &path_) {
+    std::ifstream file_(path_);
+    TEST_CHECK(file_.is_open(), "can't open fixture %s", path_.c_str());
+
+    std::vector<UniPCTrajectory> cases_;
+    std::string line_;
+    while (std::getline(file_, line_)) {
+        std::istringstream row_(line_);
+        std::string tag_;
+        row_ >> tag_;
+        double value_;
+        if (tag_ == "T") {
+            cases_.emplace_back();
+            row_ >> cases_.back().steps >> cases_.back().order;
+        } else if (tag_ == "S" && !cases_.empty()) {
+            while (row_ >> value_) { cases_.back().sigmas.push_back(value_); }
+        } else if (tag_ == "X" && !cases_.empty()) {
+            cases_.back().samples.emplace_back();
+            while (row_ >> value_) { cases_.back().samples.back().push_back(value_); }
+        }
+    }
+    return cases_;
+}
+
+// same synthetic nonlinear denoiser as unipc_trajectories.py, returns noise prediction
+static void denoise(const std::vector<float> &samples_, float sigma_, std::vector<float> &dnoise_) {
+    for (size_t k = 0; k < samples_.size(); ++k) {
+        double x_ = samples_[k];
+        double sigma_d_ = sigma_;
+        double x0_ = x_ / (1.0 + sigma_d_ * sigma_d_) + 0.1 * std::sin(x_);
+        dnoise_[k] = float((x_ - x0_) / sigma_d_);
+    }
+}
+
+static void test_trajectory(const UniPCTrajectory &case_) {
+    SchedulerConfig config_ = DEFAULT_SCHEDULER_CONFIG;
+    config_.scheduler_type = SCHEDULER_UNIPC;
+    config_.scheduler_maintain_cache = uint64_t(case_.order);
+    UniPCTestScheduler scheduler_(config_);
+    scheduler_.create();
+    scheduler_.init(uint64_t(case_.steps));
+
+    // reference is only valid for the sigmas it was made with
+    const vector<float> &sigmas_ = scheduler_.sigmas();
+    TEST_CHECK(sigmas_.size() == case_.sigmas.size() && case_.samples.size() == size_t(case_.steps),
+               "steps %ld order %ld: %zu sigmas, fixture %zu", case_.steps, case_.order, sigmas_.size(), case_.sigmas.size());
+    for (size_t i = 0; i < sigmas_.size(); ++i) {
+        TEST_CHECK(std::fabs(sigmas_[i] - case_.sigmas[i]) <= 1e-6 * std::fabs(case_.sigmas[i]),
+                   "steps %ld: sigma %zu is %.9g, fixture %.9g", case_.steps, i, sigmas_[i], case_.sigmas[i]);
+    }
+
+    // tolerance relative to the trajectory scale, entries crossing zero have no own scale
+    double scale_ = 0.0;
+    for (const auto &row_ : case_.samples) {
+        for (double v : row_) { scale_ = std::max(scale_, std::fabs(v)); }
+    }
+    double tolerance_ = (case_.order >= 4 ? TEST_UNIPC_TOLERANCE_HIGH : TEST_UNIPC_TOLERANCE) * scale_;
+
+    std::vector<float> samples_(TEST_UNIPC_LATENT_SIZE), dnoise_(TEST_UNIPC_LATENT_SIZE), output_(TEST_UNIPC_LATENT_SIZE);
+    for (long k = 0; k < TEST_UNIPC_LATENT_SIZE; ++k) {
+        samples_[k] = float(double(k - 2) * double(sigmas_[0]) * 0.7);
+    }
+    double max_error_ = 0.0;
+    for (long i = 0; i < case_.steps; ++i) {
+        denoise(samples_, sigmas_[i], dnoise_);
+        scheduler_.step(samples_.data(), dnoise_.data(), output_.data(), TEST_UNIPC_LATENT_SIZE, int(i));
+        samples_.swap(output_);
+        for (long k = 0; k < TEST_UNIPC_LATENT_SIZE; ++k) {
+            double error_ = std::fabs(double(samples_[k]) - case_.samples[i][k]);
+            max_error_ = std::max(max_error_, error_);
+            TEST_CHECK(error_ <= tolerance_,
+                       "steps %ld order %ld: step %ld entry %ld is %.9g, reference %.9g (relative error %.3g)",
+                       case_.steps, case_.order, i, k, samples_[k], case_.samples[i][k], error_ / scale_);
+        }
+    }
+    printf("steps %2ld order %ld: max relative error %.3g\n", case_.steps, case_.order, max_error_ / scale_);
+}
+
+int main(int argc, char** argv) {
+    std::vector<UniPCTrajectory> cases_ = load_fixture(argc > 1 ? argv[1] : TEST_UNIPC_FIXTURE);
+    TEST_CHECK(!cases_.empty(), "fixture has no trajectory");
+    for (const auto &case_ : cases_) { test_trajectory(case_); }
+    printf("test_unipc_trajectory passed, %zu trajectories\n", cases_.size());
+    return 0;
+}